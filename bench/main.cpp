@@ -0,0 +1,491 @@
+#include <QDataBrowser>
+
+#include "dataslice.h"
+#include "datastats.h"
+#include "qdatasliceselector.h"
+#include "qdataview.h"
+#include "syntheticstore.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScrollBar>
+#include <QSlider>
+#include <QTableView>
+#include <QTextStream>
+#include <QTimer>
+#include <QToolButton>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+// timing statistics of a benchmark case
+struct timing
+{
+    int n{0};
+    double total{0}, tmin{0}, tmax{0}; // ms
+
+    void add(double t)
+    {
+        tmin = n ? std::min(tmin, t) : t;
+        tmax = n ? std::max(tmax, t) : t;
+        total += t;
+        n++;
+    }
+    double mean() const { return n ? total / n : 0.; }
+
+    QJsonObject toJson() const
+    {
+        QJsonObject o;
+        o["n"] = n;
+        o["mean_ms"] = mean();
+        o["min_ms"] = tmin;
+        o["max_ms"] = tmax;
+        return o;
+    }
+};
+
+// run f() n times and time each call
+timing measure(int n, const std::function<void(int)> &f)
+{
+    timing t;
+    QElapsedTimer tmr;
+    for (int i = 0; i < n; ++i)
+    {
+        tmr.start();
+        f(i);
+        t.add(tmr.nsecsElapsed() * 1e-6);
+    }
+    return t;
+}
+
+AbstractDataStore::dim_t parseShape(const QString &s)
+{
+    AbstractDataStore::dim_t dim;
+    for (const QString &n : s.split('x', Qt::SkipEmptyParts))
+    {
+        bool ok;
+        qulonglong m = n.toULongLong(&ok);
+        if (!ok || m == 0)
+            return AbstractDataStore::dim_t();
+        dim.push_back(m);
+    }
+    return dim;
+}
+
+QJsonArray toJson(const AbstractDataStore::dim_t &dim)
+{
+    QJsonArray a;
+    for (size_t n : dim)
+        a.append(qint64(n));
+    return a;
+}
+
+int main(int argc, char *argv[])
+{
+    // run headless by default
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("qtdatabrowser_bench");
+
+    QDataBrowser::initResources();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QtDataBrowser benchmark on synthetic data stores");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"shape", "Data shape, e.g. 1000x1000x10", "NxMx...", "1000x1000x10"},
+        {"text", "Text data instead of numeric"},
+        {"errors", "Numeric data with errors"},
+        {"singleton", "Add singleton dims (squeezed before slicing)"},
+        {"procedural", "Compute values on the fly instead of holding them in memory"},
+        {"repeat", "Number of repetitions per case", "n", "10"},
+        {"width", "View width in pixels", "px", "800"},
+        {"height", "View height in pixels", "px", "600"},
+        {"output", "Write the JSON report to file instead of stdout", "file"},
+    });
+    parser.process(app);
+
+    AbstractDataStore::dim_t shape = parseShape(parser.value("shape"));
+    if (shape.empty())
+    {
+        std::cerr << "Invalid shape: " << parser.value("shape").toStdString() << std::endl;
+        return 1;
+    }
+    bool text = parser.isSet("text");
+    bool errors = parser.isSet("errors");
+    bool singleton = parser.isSet("singleton");
+    int nrep = std::max(parser.value("repeat").toInt(), 1);
+    QSize viewSize(parser.value("width").toInt(), parser.value("height").toInt());
+
+    AbstractDataStore::dim_t storeShape(shape);
+    if (singleton)
+    {
+        storeShape.insert(storeShape.begin(), 1);
+        storeShape.push_back(1);
+    }
+
+    /* create the data store */
+    QElapsedTimer tmr;
+    tmr.start();
+    DataStorePtr D(new SyntheticDataStore("synthetic",
+                                          storeShape,
+                                          text,
+                                          errors,
+                                          !parser.isSet("procedural")));
+    double tcreate = tmr.nsecsElapsed() * 1e-6;
+    if (singleton)
+        D = DataStorePtr(new SqueezedDataStore(D));
+
+    const AbstractDataStore::dim_t &dim = D->dim();
+    size_t ndim = D->ndim();
+
+    QJsonObject store;
+    store["shape"] = toJson(storeShape);
+    store["squeezed_shape"] = toJson(dim);
+    store["type"] = text ? "text" : "numeric";
+    store["errors"] = errors && !text;
+    store["singleton"] = singleton;
+    store["procedural"] = parser.isSet("procedural");
+    store["elements"] = qint64(D->size());
+    store["create_ms"] = tcreate;
+    store["memory_bytes"] = qint64(D->memory_usage());
+
+    QJsonObject results;
+
+    /* slice assembly */
+    {
+        DataSlice s;
+        AbstractDataStore::dim_t i0(ndim, 0);
+        results["slice_assembly_1d"] = measure(nrep, [&](int) { s.assign(D, 0, i0); }).toJson();
+        if (ndim > 1)
+        {
+            results["slice_assembly_2d"] =
+                measure(nrep, [&](int) { s.assign(D, 0, 1, i0); }).toJson();
+            results["slice_assembly_2d_transposed"] =
+                measure(nrep, [&](int) { s.assign(D, 1, 0, i0); }).toJson();
+            // cycling through axis pairs of different sizes
+            const size_t pairs[3][2] = {{0, 1}, {1, 0}, {0, ndim - 1}};
+            results["slice_axis_switch"] = measure(nrep, [&](int i) {
+                                               s.assign(D, pairs[i % 3][0], pairs[i % 3][1], i0);
+                                           }).toJson();
+        }
+        if (ndim > 2 && !text)
+        {
+            s.assign(D, 0, 1, i0);
+            for (size_t d = 2; d < ndim; ++d)
+                s.set_reduction(d, DataReduction::Sum);
+            results["reduction_sum_2d"] = measure(nrep, [&](int) { s.update(); }).toJson();
+        }
+
+        /* moving an averaging window along the 3rd dim, one step at a time */
+        if (ndim > 2 && !text && D->dim()[2] > 2)
+        {
+            for (size_t d = 2; d < ndim; ++d)
+                s.set_reduction(d, DataReduction::None);
+            s.assign(D, 0, 1, i0);
+            size_t w = D->dim()[2] / 2;
+            size_t n = D->dim()[2] - w + 1;
+            s.set_window(2, w);
+            s.update();
+            results["window_scrub"] = measure(nrep, [&](int i) {
+                                          AbstractDataStore::dim_t j(i0);
+                                          j[2] = (i + 1) % n;
+                                          s.assign(j);
+                                      }).toJson();
+        }
+    }
+
+    /* global statistics & histogram */
+    if (!text)
+    {
+        DataStats st;
+        results["dataset_stats"] = measure(nrep, [&](int) { DataStats::compute(*D, st); }).toJson();
+    }
+
+    /* slice selector: slider scrubbing & X/Y exchange */
+    QDataSliceSelector selector2d, selector1d;
+    selector2d.assign(D, 2);
+    selector1d.assign(D, 1);
+    {
+        QList<QSlider *> sliders = selector2d.findChildren<QSlider *>();
+        sliders.erase(std::remove_if(sliders.begin(),
+                                     sliders.end(),
+                                     [](QSlider *s) { return !s->isEnabled(); }),
+                      sliders.end());
+        if (!sliders.isEmpty())
+        {
+            QSlider *s = sliders.front();
+            int n = s->maximum() + 1;
+            results["slider_scrub"] = measure(nrep, [&](int i) {
+                                          s->setValue((i + 1) % n);
+                                      }).toJson();
+        }
+
+        QToolButton *bt = selector2d.findChild<QToolButton *>();
+        if (bt && bt->isEnabled())
+            results["xy_exchange"] = measure(nrep, [&](int) { bt->click(); }).toJson();
+
+        // updates without a change: re-read for a store that does not track
+        // its version, skipped once it does (not through a squeezed proxy)
+        results["selector_update"] = measure(nrep, [&](int) { selector2d.updateData(); }).toJson();
+        if (dynamic_cast<SyntheticDataStore *>(D.data()))
+        {
+            D->changed();
+            selector2d.updateData();
+            results["selector_update_unchanged"] = measure(nrep, [&](int) {
+                                                       selector2d.updateData();
+                                                   }).toJson();
+        }
+    }
+
+    QJsonObject memory;
+    memory["selector_2d_bytes"] = qint64(selector2d.memoryUsage());
+    memory["selector_1d_bytes"] = qint64(selector1d.memoryUsage());
+    memory["total_bytes"] = qint64(QDataBrowser::totalMemoryUsage());
+    report["memory"] = memory;
+
+    /* views */
+    {
+        QTabularDataView table;
+        table.resize(viewSize);
+        table.show();
+        table.setData(selector2d.slice());
+        results["table_update"] = measure(nrep, [&](int) {
+                                      table.updateView();
+                                      table.grab();
+                                  }).toJson();
+        QTableView *tv = qobject_cast<QTableView *>(table.view());
+        if (tv)
+        {
+            QScrollBar *sb = tv->verticalScrollBar();
+            int n = sb->maximum() + 1;
+            results["table_scroll"] = measure(nrep, [&](int i) {
+                                          sb->setValue((i + 1) * sb->pageStep() % n);
+                                          table.grab();
+                                      }).toJson();
+        }
+    }
+    if (!text)
+    {
+        QPlotDataView plot;
+        plot.resize(viewSize);
+        plot.show();
+        plot.setData(selector1d.slice());
+        results["plot_render"] = measure(nrep, [&](int) {
+                                     plot.updateView();
+                                     plot.grab();
+                                 }).toJson();
+
+        QHeatMapDataView heatmap;
+        heatmap.resize(viewSize);
+        heatmap.show();
+        heatmap.setData(selector2d.slice());
+        results["heatmap_render"] = measure(nrep, [&](int) {
+                                        heatmap.updateView();
+                                        heatmap.grab();
+                                    }).toJson();
+        // fixed color limits: no min/max pass, only the LUT mapping
+        heatmap.setFixedLimits(-1., 2.);
+        results["heatmap_render_fixed"] = measure(nrep, [&](int) {
+                                              heatmap.updateView();
+                                              heatmap.grab();
+                                          }).toJson();
+
+        // playback at 100 fps for 1 s, frames colored in the player threads
+        QToolButton *play = selector2d.findChild<QToolButton *>("play");
+        if (play && play->isEnabled())
+        {
+            selector2d.setFramePreparer([&heatmap]() { return heatmap.framePreparer(); });
+            QObject::connect(&selector2d,
+                             &QDataSliceSelector::frameChanged,
+                             &heatmap,
+                             &QAbstractDataView::showFrame);
+            selector2d.player()->setFps(100);
+            QEventLoop loop;
+            QTimer::singleShot(1000, &loop, &QEventLoop::quit);
+            play->click();
+            loop.exec();
+            const FramePlayer *p = selector2d.player();
+            QJsonObject o;
+            o["target_fps"] = p->fps();
+            o["shown"] = qint64(p->shown());
+            o["dropped"] = qint64(p->dropped());
+            results["heatmap_playback"] = o;
+            selector2d.stopPlayback();
+            selector2d.disconnect(&heatmap);
+        }
+
+        // a row of live data changes & is reported as a range: only that
+        // row is re-read & recolored
+        SyntheticDataStore *sd = dynamic_cast<SyntheticDataStore *>(D.data());
+        DataSlice *s2 = selector2d.slice();
+        if (sd && s2->ndim() > 1 && !singleton && !parser.isSet("procedural"))
+        {
+            size_t ny = s2->dim()[1];
+            results["heatmap_partial_update"] = measure(nrep, [&](int i) {
+                                                    AbstractDataStore::dim_t j(s2->i0());
+                                                    j[s2->dy()] = (i * 7) % ny;
+                                                    sd->setValue(j, i % 3 - 1.);
+                                                    s2->update(s2->dy(), j[s2->dy()], j[s2->dy()] + 1);
+                                                    heatmap.updateView();
+                                                }).toJson();
+        }
+
+        // all traces vs every k-th one: each call decimates all shown traces
+        QTracesDataView traces;
+        traces.resize(viewSize);
+        traces.show();
+        traces.setData(selector2d.slice());
+        results["traces_render"] = measure(nrep, [&](int i) {
+                                       traces.setMaxTraces(i % 2 ? 0 : 512);
+                                       traces.grab();
+                                   }).toJson();
+
+        QHistogramDataView hist;
+        hist.resize(viewSize);
+        hist.show();
+        hist.setData(selector2d.slice());
+        results["histogram_bin"] = measure(nrep, [&](int) { hist.updateView(); }).toJson();
+        results["histogram_rebin"] = measure(nrep, [&](int i) {
+                                         hist.setBinCount(16 << (i % 6));
+                                     }).toJson();
+    }
+
+    /* data tree: bulk load of many datasets into one group & path lookups */
+    {
+        const int nitems = 20000;
+        QDataBrowser browser;
+        browser.addGroup("bulk");
+        {
+            QJsonObject o = measure(nrep, [&](int) {
+                                browser.clear("/bulk");
+                                browser.addGroup("bulk");
+                                for (int k = 0; k < nitems; ++k)
+                                    browser.addData(new SyntheticDataStore("d" + std::to_string(k), {2}),
+                                                    "/bulk");
+                            }).toJson();
+            o["tree_bytes_per_node"] = double(browser.treeMemoryUsage()) / nitems;
+            results["tree_bulk_add"] = o;
+        }
+        results["tree_batch_add"] = measure(nrep, [&](int) {
+                                        browser.clear("/bulk");
+                                        QList<QPair<QString, AbstractDataStore *>> items;
+                                        for (int k = 0; k < nitems; ++k)
+                                            items.append({QString("/bulk/g%1").arg(k % 100),
+                                                          new SyntheticDataStore(
+                                                              "d" + std::to_string(k), {2})});
+                                        browser.addData(items);
+                                    }).toJson();
+        browser.clear("/bulk");
+        browser.addGroup("bulk");
+        for (int k = 0; k < nitems; ++k)
+            browser.addData(new SyntheticDataStore("d" + std::to_string(k), {2}), "/bulk");
+        results["tree_path_lookup"] = measure(nrep, [&](int i) {
+                                          browser.dataUpdated(
+                                              QString("/bulk/d%1").arg((i * 7919) % nitems));
+                                      }).toJson();
+
+        results["tree_update_root"] = measure(nrep, [&](int) { browser.dataUpdated("/"); }).toJson();
+
+        // typing a filter, one character at a time
+        const QString typed("d1234");
+        results["tree_filter"] = measure(nrep, [&](int i) {
+                                     browser.setFilter(typed.left(1 + i % typed.size()));
+                                 }).toJson();
+        browser.setFilter(QString());
+
+        // a catalog of 100 x 200 datasets, listed & opened on demand
+        browser.clear("/bulk");
+        auto lazyItems = [] {
+            QList<QDataBrowser::LazyNode> items;
+            for (int k = 0; k < nitems / 100; ++k)
+                items.append({QString("d%1").arg(k), QString(), nullptr, [k] {
+                                  return new SyntheticDataStore("d" + std::to_string(k), {2});
+                              }});
+            return items;
+        };
+        auto lazyGroups = [lazyItems] {
+            QList<QDataBrowser::LazyNode> groups;
+            for (int g = 0; g < 100; ++g)
+                groups.append({QString("g%1").arg(g), QString(), lazyItems, nullptr});
+            return groups;
+        };
+        results["tree_lazy_add"] = measure(nrep, [&](int) {
+                                       browser.clear("/lazy");
+                                       browser.addLazyGroup("lazy", lazyGroups);
+                                   }).toJson();
+        results["tree_lazy_select"] = measure(nrep, [&](int i) {
+                                          browser.selectItem(QString("/lazy/g%1/d%2")
+                                                                 .arg((i * 31) % 100)
+                                                                 .arg((i * 7919) % (nitems / 100)));
+                                      }).toJson();
+    }
+
+    /* browser startup: only the table view vs all views created */
+    {
+        int objects = 0;
+        QJsonObject o = measure(nrep, [&](int) {
+                            QDataBrowser b;
+                            objects = b.findChildren<QObject *>().size();
+                        }).toJson();
+        o["objects"] = objects;
+        results["browser_create"] = o;
+
+        o = measure(nrep, [&](int) {
+                QDataBrowser b;
+                for (const QDataBrowser::ViewInfo &v : QDataBrowser::registeredViews())
+                    b.setActiveView(QDataBrowser::ViewType(v.id));
+                objects = b.findChildren<QObject *>().size();
+            }).toJson();
+        o["objects"] = objects;
+        results["browser_create_all_views"] = o;
+    }
+
+    /* csv export */
+    {
+        DataSlice *s = selector2d.slice();
+        size_t bytes = 0;
+        timing t = measure(nrep, [&](int) {
+            std::ostringstream os;
+            s->export_csv(os);
+            bytes = os.tellp();
+        });
+        QJsonObject o = t.toJson();
+        o["bytes"] = qint64(bytes);
+        o["MB_per_s"] = t.mean() > 0 ? bytes / t.mean() * 1e-3 : 0.;
+        results["csv_export"] = o;
+    }
+
+    QJsonObject report;
+    report["benchmark"] = QApplication::applicationName();
+    report["platform"] = QApplication::platformName();
+    report["repeat"] = nrep;
+    report["store"] = store;
+    report["results"] = results;
+    QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet("output"))
+    {
+        QFile f(parser.value("output"));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            std::cerr << "Error opening file: " << f.fileName().toStdString() << std::endl;
+            return 1;
+        }
+        f.write(json);
+    }
+    else
+        std::cout << json.toStdString();
+
+    return 0;
+}
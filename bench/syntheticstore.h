@@ -0,0 +1,127 @@
+#ifndef SYNTHETICSTORE_H
+#define SYNTHETICSTORE_H
+
+#include <QDataBrowser>
+
+#include <cmath>
+#include <memory>
+
+// N-D synthetic data store for benchmarking
+//
+// Values are a deterministic function of the linear (row-major) index,
+// so that any slice can be checked against the store.
+// If the data is materialized, the values are held in memory,
+// otherwise they are computed on the fly, which allows
+// arbitrarily large (GB sized) virtual datasets
+class SyntheticDataStore : public AbstractDataStore
+{
+public:
+    SyntheticDataStore(const std::string &name,
+                       const dim_t &shape,
+                       bool text = false,
+                       bool errors = false,
+                       bool materialize = true)
+        : AbstractDataStore(name, shape), text_(text), errors_(errors && !text),
+          stride_(shape.size(), 1)
+    {
+        for (int i = int(shape.size()) - 2; i >= 0; --i)
+            stride_[i] = stride_[i + 1] * shape[i + 1];
+        if (materialize && !text_) {
+            y_ = std::make_shared<vec_t>(size());
+            double *p = y_->data();
+            for (size_t k = 0; k < y_->size(); ++k)
+                p[k] = value(k);
+        }
+        desc_ = text_ ? "Synthetic text data" : "Synthetic numeric data";
+    }
+
+    bool is_numeric() const override { return !text_; }
+    bool hasErrors() const override { return errors_; }
+    size_t memory_usage() const override
+    {
+        return sizeof(*this) + (y_ ? y_->capacity() * sizeof(double) : 0);
+    }
+
+    // the value stored at linear index k
+    static double value(size_t k)
+    {
+        return std::sin(1e-3 * k) + 1e-3 * double(hash(k) & 0x3ff);
+    }
+    static double error(size_t k) { return 0.05 + 0.1 * std::abs(value(k)); }
+    static std::string text(size_t k)
+    {
+        // small vocabulary, many repeated values
+        return std::string("item_") + std::to_string(hash(k) % 97);
+    }
+
+    size_t idx(const dim_t &i) const
+    {
+        size_t k{0};
+        for (size_t j = 0; j < i.size(); ++j)
+            k += i[j] * stride_[j];
+        return k;
+    }
+    size_t stride(size_t d) const { return stride_[d]; }
+
+    // overwrite a value of materialized data, e.g. to simulate a live update
+    bool setValue(const dim_t &i, double v)
+    {
+        if (!y_)
+            return false;
+        (*y_)[idx(i)] = v;
+        return true;
+    }
+
+    size_t get_y_text(size_t d, const dim_t &i0, strvec_t &y) const override
+    {
+        size_t k = idx(i0);
+        size_t m = std::min(y.size(), dim_[d] - i0[d]);
+        for (size_t i = 0; i < m; ++i, k += stride_[d])
+            y[i] = text(k);
+        return m;
+    }
+
+protected:
+    bool text_;
+    bool errors_;
+    dim_t stride_;
+    std::shared_ptr<vec_t> y_;
+
+    static size_t hash(size_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    size_t get_y(size_t d, const dim_t &i0, size_t n, double *v) const override
+    {
+        size_t k = idx(i0);
+        size_t s = stride_[d];
+        size_t m = std::min(n, dim_[d] - i0[d]);
+        if (y_) {
+            const double *p = y_->data() + k;
+            if (s == 1)
+                std::copy(p, p + m, v);
+            else
+                for (size_t i = 0; i < m; ++i, p += s)
+                    v[i] = *p;
+        } else {
+            for (size_t i = 0; i < m; ++i, k += s)
+                v[i] = value(k);
+        }
+        return m;
+    }
+    size_t get_dy(size_t d, const dim_t &i0, size_t n, double *v) const override
+    {
+        size_t k = idx(i0);
+        size_t s = stride_[d];
+        size_t m = std::min(n, dim_[d] - i0[d]);
+        for (size_t i = 0; i < m; ++i, k += s)
+            v[i] = error(k);
+        return m;
+    }
+};
+
+#endif // SYNTHETICSTORE_H
@@ -0,0 +1,264 @@
+#include "colormap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+double clamp01(double x)
+{
+    return x < 0. ? 0. : (x > 1. ? 1. : x);
+}
+
+QRgb rgb(double r, double g, double b)
+{
+    return qRgb(int(255. * clamp01(r) + 0.5), int(255. * clamp01(g) + 0.5), int(255. * clamp01(b) + 0.5));
+}
+
+// The palettes are matplotlib's colormaps: tables of paletteSize colors,
+// where a fraction t of the color range gets color floor(t * paletteSize).
+// viridis & turbo are the published tables (matplotlib _cm_listed.py)
+// rounded to 8 bits, jet & gray are sampled from their linear segments
+const int paletteSize = 256;
+
+const QRgb viridis[paletteSize] = {
+    0xff440154, 0xff440256, 0xff450457, 0xff450559, 0xff46075a, 0xff46085c, 0xff460a5d, 0xff460b5e,
+    0xff470d60, 0xff470e61, 0xff471063, 0xff471164, 0xff471365, 0xff481467, 0xff481668, 0xff481769,
+    0xff48186a, 0xff481a6c, 0xff481b6d, 0xff481c6e, 0xff481d6f, 0xff481f70, 0xff482071, 0xff482173,
+    0xff482374, 0xff482475, 0xff482576, 0xff482677, 0xff482878, 0xff482979, 0xff472a7a, 0xff472c7a,
+    0xff472d7b, 0xff472e7c, 0xff472f7d, 0xff46307e, 0xff46327e, 0xff46337f, 0xff463480, 0xff453581,
+    0xff453781, 0xff453882, 0xff443983, 0xff443a83, 0xff443b84, 0xff433d84, 0xff433e85, 0xff423f85,
+    0xff424086, 0xff424186, 0xff414287, 0xff414487, 0xff404588, 0xff404688, 0xff3f4788, 0xff3f4889,
+    0xff3e4989, 0xff3e4a89, 0xff3e4c8a, 0xff3d4d8a, 0xff3d4e8a, 0xff3c4f8a, 0xff3c508b, 0xff3b518b,
+    0xff3b528b, 0xff3a538b, 0xff3a548c, 0xff39558c, 0xff39568c, 0xff38588c, 0xff38598c, 0xff375a8c,
+    0xff375b8d, 0xff365c8d, 0xff365d8d, 0xff355e8d, 0xff355f8d, 0xff34608d, 0xff34618d, 0xff33628d,
+    0xff33638d, 0xff32648e, 0xff32658e, 0xff31668e, 0xff31678e, 0xff31688e, 0xff30698e, 0xff306a8e,
+    0xff2f6b8e, 0xff2f6c8e, 0xff2e6d8e, 0xff2e6e8e, 0xff2e6f8e, 0xff2d708e, 0xff2d718e, 0xff2c718e,
+    0xff2c728e, 0xff2c738e, 0xff2b748e, 0xff2b758e, 0xff2a768e, 0xff2a778e, 0xff2a788e, 0xff29798e,
+    0xff297a8e, 0xff297b8e, 0xff287c8e, 0xff287d8e, 0xff277e8e, 0xff277f8e, 0xff27808e, 0xff26818e,
+    0xff26828e, 0xff26828e, 0xff25838e, 0xff25848e, 0xff25858e, 0xff24868e, 0xff24878e, 0xff23888e,
+    0xff23898e, 0xff238a8d, 0xff228b8d, 0xff228c8d, 0xff228d8d, 0xff218e8d, 0xff218f8d, 0xff21908d,
+    0xff21918c, 0xff20928c, 0xff20928c, 0xff20938c, 0xff1f948c, 0xff1f958b, 0xff1f968b, 0xff1f978b,
+    0xff1f988b, 0xff1f998a, 0xff1f9a8a, 0xff1e9b8a, 0xff1e9c89, 0xff1e9d89, 0xff1f9e89, 0xff1f9f88,
+    0xff1fa088, 0xff1fa188, 0xff1fa187, 0xff1fa287, 0xff20a386, 0xff20a486, 0xff21a585, 0xff21a685,
+    0xff22a785, 0xff22a884, 0xff23a983, 0xff24aa83, 0xff25ab82, 0xff25ac82, 0xff26ad81, 0xff27ad81,
+    0xff28ae80, 0xff29af7f, 0xff2ab07f, 0xff2cb17e, 0xff2db27d, 0xff2eb37c, 0xff2fb47c, 0xff31b57b,
+    0xff32b67a, 0xff34b679, 0xff35b779, 0xff37b878, 0xff38b977, 0xff3aba76, 0xff3bbb75, 0xff3dbc74,
+    0xff3fbc73, 0xff40bd72, 0xff42be71, 0xff44bf70, 0xff46c06f, 0xff48c16e, 0xff4ac16d, 0xff4cc26c,
+    0xff4ec36b, 0xff50c46a, 0xff52c569, 0xff54c568, 0xff56c667, 0xff58c765, 0xff5ac864, 0xff5cc863,
+    0xff5ec962, 0xff60ca60, 0xff63cb5f, 0xff65cb5e, 0xff67cc5c, 0xff69cd5b, 0xff6ccd5a, 0xff6ece58,
+    0xff70cf57, 0xff73d056, 0xff75d054, 0xff77d153, 0xff7ad151, 0xff7cd250, 0xff7fd34e, 0xff81d34d,
+    0xff84d44b, 0xff86d549, 0xff89d548, 0xff8bd646, 0xff8ed645, 0xff90d743, 0xff93d741, 0xff95d840,
+    0xff98d83e, 0xff9bd93c, 0xff9dd93b, 0xffa0da39, 0xffa2da37, 0xffa5db36, 0xffa8db34, 0xffaadc32,
+    0xffaddc30, 0xffb0dd2f, 0xffb2dd2d, 0xffb5de2b, 0xffb8de29, 0xffbade28, 0xffbddf26, 0xffc0df25,
+    0xffc2df23, 0xffc5e021, 0xffc8e020, 0xffcae11f, 0xffcde11d, 0xffd0e11c, 0xffd2e21b, 0xffd5e21a,
+    0xffd8e219, 0xffdae319, 0xffdde318, 0xffdfe318, 0xffe2e418, 0xffe5e419, 0xffe7e419, 0xffeae51a,
+    0xffece51b, 0xffefe51c, 0xfff1e51d, 0xfff4e61e, 0xfff6e620, 0xfff8e621, 0xfffbe723, 0xfffde725};
+
+const QRgb turbo[paletteSize] = {
+    0xff30123b, 0xff321543, 0xff33184a, 0xff341b51, 0xff351e58, 0xff36215f, 0xff372466, 0xff38276d,
+    0xff392a73, 0xff3a2d79, 0xff3b2f80, 0xff3c3286, 0xff3d358b, 0xff3e3891, 0xff3f3b97, 0xff3f3e9c,
+    0xff4040a2, 0xff4143a7, 0xff4146ac, 0xff4249b1, 0xff424bb5, 0xff434eba, 0xff4451bf, 0xff4454c3,
+    0xff4456c7, 0xff4559cb, 0xff455ccf, 0xff455ed3, 0xff4661d6, 0xff4664da, 0xff4666dd, 0xff4669e0,
+    0xff466be3, 0xff476ee6, 0xff4771e9, 0xff4773eb, 0xff4776ee, 0xff4778f0, 0xff477bf2, 0xff467df4,
+    0xff4680f6, 0xff4682f8, 0xff4685fa, 0xff4687fb, 0xff458afc, 0xff458cfd, 0xff448ffe, 0xff4391fe,
+    0xff4294ff, 0xff4196ff, 0xff4099ff, 0xff3e9bfe, 0xff3d9efe, 0xff3ba0fd, 0xff3aa3fc, 0xff38a5fb,
+    0xff37a8fa, 0xff35abf8, 0xff33adf7, 0xff31aff5, 0xff2fb2f4, 0xff2eb4f2, 0xff2cb7f0, 0xff2ab9ee,
+    0xff28bceb, 0xff27bee9, 0xff25c0e7, 0xff23c3e4, 0xff22c5e2, 0xff20c7df, 0xff1fc9dd, 0xff1ecbda,
+    0xff1ccdd8, 0xff1bd0d5, 0xff1ad2d2, 0xff1ad4d0, 0xff19d5cd, 0xff18d7ca, 0xff18d9c8, 0xff18dbc5,
+    0xff18ddc2, 0xff18dec0, 0xff18e0bd, 0xff19e2bb, 0xff19e3b9, 0xff1ae4b6, 0xff1ce6b4, 0xff1de7b2,
+    0xff1fe9af, 0xff20eaac, 0xff22ebaa, 0xff25eca7, 0xff27eea4, 0xff2aefa1, 0xff2cf09e, 0xff2ff19b,
+    0xff32f298, 0xff35f394, 0xff38f491, 0xff3cf58e, 0xff3ff68a, 0xff43f787, 0xff46f884, 0xff4af880,
+    0xff4ef97d, 0xff52fa7a, 0xff55fa76, 0xff59fb73, 0xff5dfc6f, 0xff61fc6c, 0xff65fd69, 0xff69fd66,
+    0xff6dfe62, 0xff71fe5f, 0xff75fe5c, 0xff79fe59, 0xff7dff56, 0xff80ff53, 0xff84ff51, 0xff88ff4e,
+    0xff8bff4b, 0xff8fff49, 0xff92ff47, 0xff96fe44, 0xff99fe42, 0xff9cfe40, 0xff9ffd3f, 0xffa1fd3d,
+    0xffa4fc3c, 0xffa7fc3a, 0xffa9fb39, 0xffacfb38, 0xffaffa37, 0xffb1f936, 0xffb4f836, 0xffb7f735,
+    0xffb9f635, 0xffbcf534, 0xffbef434, 0xffc1f334, 0xffc3f134, 0xffc6f034, 0xffc8ef34, 0xffcbed34,
+    0xffcdec34, 0xffd0ea34, 0xffd2e935, 0xffd4e735, 0xffd7e535, 0xffd9e436, 0xffdbe236, 0xffdde037,
+    0xffdfdf37, 0xffe1dd37, 0xffe3db38, 0xffe5d938, 0xffe7d739, 0xffe9d539, 0xffebd339, 0xffecd13a,
+    0xffeecf3a, 0xffefcd3a, 0xfff1cb3a, 0xfff2c93a, 0xfff4c73a, 0xfff5c53a, 0xfff6c33a, 0xfff7c13a,
+    0xfff8be39, 0xfff9bc39, 0xfffaba39, 0xfffbb838, 0xfffbb637, 0xfffcb336, 0xfffcb136, 0xfffdae35,
+    0xfffdac34, 0xfffea933, 0xfffea732, 0xfffea431, 0xfffea130, 0xfffe9e2f, 0xfffe9b2d, 0xfffe992c,
+    0xfffe962b, 0xfffe932a, 0xfffe9029, 0xfffd8d27, 0xfffd8a26, 0xfffc8725, 0xfffc8423, 0xfffb8122,
+    0xfffb7e21, 0xfffa7b1f, 0xfff9781e, 0xfff9751d, 0xfff8721c, 0xfff76f1a, 0xfff66c19, 0xfff56918,
+    0xfff46617, 0xfff36315, 0xfff26014, 0xfff15d13, 0xfff05b12, 0xffef5811, 0xffed5510, 0xffec530f,
+    0xffeb500e, 0xffea4e0d, 0xffe84b0c, 0xffe7490c, 0xffe5470b, 0xffe4450a, 0xffe2430a, 0xffe14109,
+    0xffdf3f08, 0xffdd3d08, 0xffdc3b07, 0xffda3907, 0xffd83706, 0xffd63506, 0xffd43305, 0xffd23105,
+    0xffd02f05, 0xffce2d04, 0xffcc2b04, 0xffca2a04, 0xffc82803, 0xffc52603, 0xffc32503, 0xffc12302,
+    0xffbe2102, 0xffbc2002, 0xffb91e02, 0xffb71d02, 0xffb41b01, 0xffb21a01, 0xffaf1801, 0xffac1701,
+    0xffa91601, 0xffa71401, 0xffa41301, 0xffa11201, 0xff9e1001, 0xff9b0f01, 0xff980e01, 0xff950d01,
+    0xff920b01, 0xff8e0a01, 0xff8b0902, 0xff880802, 0xff850702, 0xff810602, 0xff7e0502, 0xff7a0403};
+
+// {x, value} nodes of a linear segment colormap channel
+struct Node
+{
+    double x, v;
+};
+
+double segment(const Node *s, double x)
+{
+    while (x > s[1].x)
+        ++s;
+    return s[0].v + (x - s[0].x) * (s[1].v - s[0].v) / (s[1].x - s[0].x);
+}
+
+// matplotlib _cm.py _jet_data
+QRgb jet(double x)
+{
+    static const Node r[] = {{0., 0.}, {0.35, 0.}, {0.66, 1.}, {0.89, 1.}, {1., 0.5}};
+    static const Node g[] = {{0., 0.}, {0.125, 0.}, {0.375, 1.}, {0.64, 1.}, {0.91, 0.}, {1., 0.}};
+    static const Node b[] = {{0., 0.5}, {0.11, 1.}, {0.34, 1.}, {0.65, 0.}, {1., 0.}};
+    return rgb(segment(r, x), segment(g, x), segment(b, x));
+}
+
+// color k of the palette table
+QRgb paletteColor(ColorMap::Palette p, int k)
+{
+    const double x = double(k) / (paletteSize - 1);
+    switch (p) {
+    case ColorMap::Turbo:
+        return turbo[k];
+    case ColorMap::Jet:
+        return jet(x);
+    case ColorMap::Gray:
+        return rgb(x, x, x);
+    default:
+        return viridis[k];
+    }
+}
+
+} // namespace
+
+ColorMap::ColorMap(Palette p)
+    : palette_(p), lut_(lutSize + 1)
+{
+    setPalette(p);
+    setNanColor(qRgb(255, 255, 255));
+}
+
+void ColorMap::setPalette(Palette p)
+{
+    palette_ = p;
+    for (int i = 0; i < lutSize; ++i) {
+        double t = double(i) / (lutSize - 1);
+        lut_[i] = paletteColor(p, std::min(int(t * paletteSize), paletteSize - 1));
+    }
+}
+
+void ColorMap::setScale(Scale s)
+{
+    scale_ = s;
+    update_();
+}
+
+void ColorMap::setLimits(double lo, double hi)
+{
+    lim_[0] = lo;
+    lim_[1] = hi;
+    update_();
+}
+
+void ColorMap::setLinearThreshold(double c)
+{
+    linthresh_ = c;
+    update_();
+}
+
+void ColorMap::update_()
+{
+    c_ = linthresh_ > 0. ? linthresh_
+                         : 1e-3 * std::max(std::abs(lim_[0]), std::abs(lim_[1]));
+    if (!(c_ > 0.))
+        c_ = 1.;
+    double u0 = transform(lim_[0]), u1 = transform(lim_[1]);
+    u0_ = u0;
+    f_ = (u1 > u0) ? (lutSize - 1) / (u1 - u0) : 0.;
+}
+
+double ColorMap::transform(double v) const
+{
+    switch (scale_) {
+    case Log:
+        return v > 0. ? std::log10(v) : std::numeric_limits<double>::quiet_NaN();
+    case SymLog:
+        return std::copysign(std::log10(1. + std::abs(v) / c_), v);
+    default:
+        return v;
+    }
+}
+
+double ColorMap::inverse(double u) const
+{
+    switch (scale_) {
+    case Log:
+        return std::pow(10., u);
+    case SymLog:
+        return std::copysign(c_ * (std::pow(10., std::abs(u)) - 1.), u);
+    default:
+        return u;
+    }
+}
+
+QRgb ColorMap::color(double t) const
+{
+    return lut_[int(clamp01(t) * (lutSize - 1) + 0.5)];
+}
+
+void ColorMap::map(const double *v, size_t n, QRgb *out) const
+{
+    const QRgb *lut = lut_.data();
+    const double u0 = u0_, f = f_;
+    const double imax = lutSize - 1;
+
+    // blocks of lut indexes & color lookups, kept in simple loops
+    // so that the index computation vectorizes
+    // NaN gets index lutSize, the nan color
+    const size_t block = 256;
+    double u[block];
+    int idx[block];
+    for (size_t i0 = 0; i0 < n; i0 += block) {
+        const size_t m = std::min(block, n - i0);
+        const double *__restrict x = v + i0;
+        switch (scale_) {
+        case Log:
+            for (size_t i = 0; i < m; ++i)
+                u[i] = x[i] > 0. ? std::log10(x[i]) : std::numeric_limits<double>::quiet_NaN();
+            x = u;
+            break;
+        case SymLog: {
+            const double ic = 1. / c_;
+            for (size_t i = 0; i < m; ++i)
+                u[i] = std::copysign(std::log10(1. + std::abs(x[i]) * ic), x[i]);
+            x = u;
+            break;
+        }
+        default:
+            break;
+        }
+        for (size_t i = 0; i < m; ++i) {
+            double t = (x[i] - u0) * f;
+            t = t < 0. ? 0. : t;
+            t = t > imax ? imax : t;
+            idx[i] = t == t ? int(t + 0.5) : lutSize;
+        }
+        QRgb *__restrict o = out + i0;
+        for (size_t i = 0; i < m; ++i)
+            o[i] = lut[idx[i]];
+    }
+}
+
+bool ColorMap::range(const double *v, size_t n, Scale s, double &lo, double &hi)
+{
+    lo = std::numeric_limits<double>::infinity();
+    hi = -lo;
+    const double vmin = s == Log ? 0. : -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i) {
+        double x = v[i];
+        if (x > vmin && x < std::numeric_limits<double>::infinity()) {
+            lo = x < lo ? x : lo;
+            hi = x > hi ? x : hi;
+        }
+    }
+    return lo <= hi;
+}
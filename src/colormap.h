@@ -0,0 +1,75 @@
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+#include <QRgb>
+
+#include <cstddef>
+#include <vector>
+
+// Mapping of data values to colors
+//
+// Values are transformed by the color scale (linear, log or symlog),
+// normalized to the color limits and looked up in a precomputed table
+// of lutSize colors. Values outside the limits get the end colors,
+// NaN and values not representable in the scale (e.g. <= 0 for log)
+// get the nan color.
+class ColorMap
+{
+public:
+    // same order as the QMatPlotWidget colormaps
+    enum Palette { Viridis, Turbo, Jet, Gray };
+    enum Scale { Linear, Log, SymLog };
+
+    static const int lutSize = 1024;
+
+    explicit ColorMap(Palette p = Viridis);
+
+    Palette palette() const { return palette_; }
+    void setPalette(Palette p);
+
+    Scale scale() const { return scale_; }
+    void setScale(Scale s);
+
+    // color limits in data units
+    double lo() const { return lim_[0]; }
+    double hi() const { return lim_[1]; }
+    void setLimits(double lo, double hi);
+
+    // linear range around 0 of the symlog scale, 0 = automatic
+    // (1e-3 of the largest abs limit)
+    double linearThreshold() const { return linthresh_; }
+    void setLinearThreshold(double c);
+
+    QRgb nanColor() const { return lut_[lutSize]; }
+    void setNanColor(QRgb c) { lut_[lutSize] = c; }
+
+    // color at fraction t in [0, 1] of the color range
+    QRgb color(double t) const;
+
+    // map n values to colors
+    void map(const double *v, size_t n, QRgb *out) const;
+
+    // the transformed value, on which the colors are linear
+    double transform(double v) const;
+    // inverse of transform
+    double inverse(double u) const;
+
+    // the min & max of the finite values of v, for the log scale
+    // the min of the positive values
+    static bool range(const double *v, size_t n, Scale s, double &lo, double &hi);
+
+private:
+    Palette palette_;
+    Scale scale_{Linear};
+    double lim_[2]{0., 1.};
+    double linthresh_{0.};
+    std::vector<QRgb> lut_; // lutSize colors + the nan color
+
+    // cached transformed limits
+    double c_{1.};
+    double u0_{0.}, f_{1.};
+
+    void update_();
+};
+
+#endif // COLORMAP_H
@@ -0,0 +1,307 @@
+#include "datareduction.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+
+std::atomic<int> max_threads_{0};
+
+// below this number of values the reduction runs in the calling thread
+const size_t min_parallel_size = 1 << 16;
+
+// min time between progress reports
+const std::chrono::milliseconds progress_interval(50);
+
+void init(DataReduction::op_t op, double *acc, double *acc2, size_t n)
+{
+    switch (op) {
+    case DataReduction::Min:
+        std::fill(acc, acc + n, std::numeric_limits<double>::infinity());
+        break;
+    case DataReduction::Max:
+        std::fill(acc, acc + n, -std::numeric_limits<double>::infinity());
+        break;
+    case DataReduction::Std:
+        std::fill(acc2, acc2 + n, 0.);
+        // fall through
+    default:
+        std::fill(acc, acc + n, 0.);
+        break;
+    }
+}
+
+// accumulate v into acc, acc2
+// for Std, acc & acc2 hold the mean & the sum of squared deviations of the
+// na values accumulated so far: v is the value number na + 1 (Welford's
+// update), or with v2 the mean & squared deviations of nb other values
+// (Chan et al. merge), which avoids the cancellation of sum(v^2) - n mean^2
+// the loops are kept simple so that the compiler can vectorize them
+void combine(DataReduction::op_t op,
+             const double *__restrict v,
+             const double *__restrict v2,
+             double *__restrict acc,
+             double *__restrict acc2,
+             size_t n,
+             size_t na = 0,
+             size_t nb = 1)
+{
+    switch (op) {
+    case DataReduction::Min:
+        for (size_t i = 0; i < n; ++i)
+            acc[i] = v[i] < acc[i] ? v[i] : acc[i];
+        break;
+    case DataReduction::Max:
+        for (size_t i = 0; i < n; ++i)
+            acc[i] = v[i] > acc[i] ? v[i] : acc[i];
+        break;
+    case DataReduction::Std:
+        if (v2) { // merge partial results
+            const double fb = double(nb) / (na + nb), fab = double(na) * fb;
+            for (size_t i = 0; i < n; ++i) {
+                double delta = v[i] - acc[i];
+                acc[i] += delta * fb;
+                acc2[i] += v2[i] + delta * delta * fab;
+            }
+        } else {
+            const double f = 1.0 / (na + 1);
+            for (size_t i = 0; i < n; ++i) {
+                double delta = v[i] - acc[i];
+                acc[i] += delta * f;
+                acc2[i] += delta * (v[i] - acc[i]);
+            }
+        }
+        break;
+    default:
+        for (size_t i = 0; i < n; ++i)
+            acc[i] += v[i];
+        break;
+    }
+}
+
+// final result of m accumulated values
+void finalize(DataReduction::op_t op,
+              const double *__restrict acc,
+              const double *__restrict acc2,
+              size_t m,
+              double *__restrict out,
+              size_t n)
+{
+    const double f = 1.0 / m;
+    switch (op) {
+    case DataReduction::Mean:
+        for (size_t i = 0; i < n; ++i)
+            out[i] = acc[i] * f;
+        break;
+    case DataReduction::Std:
+        for (size_t i = 0; i < n; ++i)
+            out[i] = std::sqrt(acc2[i] * f);
+        break;
+    default:
+        std::copy(acc, acc + n, out);
+        break;
+    }
+}
+
+} // namespace
+
+struct DataReduction::worker
+{
+    DataReduction::dim_t i;
+    std::vector<std::vector<double>> acc, acc2, tmp;
+    const DataReduction::fetch_t *fetch;
+    std::atomic<size_t> *done;
+    std::atomic<bool> *cancel;
+
+    // progress reporting, single threaded mode only
+    const DataReduction::progress_t *progress{nullptr};
+    size_t total{0};
+    std::chrono::steady_clock::time_point t0;
+
+    worker(const DataReduction::dim_t &i0, size_t nlevels, size_t n)
+        : i(i0), acc(nlevels, std::vector<double>(n)), acc2(nlevels), tmp(nlevels, std::vector<double>(n))
+    {}
+};
+
+DataReduction::DataReduction(const dim_t &shape, size_t n)
+    : shape_(shape), n_(n)
+{}
+
+void DataReduction::add(size_t d, op_t op, size_t k0, size_t k1)
+{
+    if (op == None || d >= shape_.size())
+        return;
+    k1 = std::min(k1, shape_[d]);
+    if (k0 < k1)
+        levels_.push_back({d, op, k0, k1});
+}
+
+size_t DataReduction::count() const
+{
+    size_t m{1};
+    for (const level &l : levels_)
+        m *= l.k1 - l.k0;
+    return m;
+}
+
+int DataReduction::maxThreads()
+{
+    int n = max_threads_;
+    if (n <= 0)
+        n = std::max(1u, std::thread::hardware_concurrency());
+    return n;
+}
+
+void DataReduction::setMaxThreads(int n)
+{
+    max_threads_ = n;
+}
+
+const char *DataReduction::name(op_t op)
+{
+    switch (op) {
+    case Sum:
+        return "Sum";
+    case Mean:
+        return "Mean";
+    case Min:
+        return "Min";
+    case Max:
+        return "Max";
+    case Std:
+        return "Std";
+    default:
+        return "Index";
+    }
+}
+
+// accumulate level l over [k0,k1) of its dimension into w.acc[l], w.acc2[l]
+// if partial is false, the final result is written to out
+bool DataReduction::reduce(size_t l, size_t k0, size_t k1, worker &w, double *out, bool partial) const
+{
+    const level &L = levels_[l];
+    double *acc = w.acc[l].data();
+    if (L.op == Std && w.acc2[l].size() != n_)
+        w.acc2[l].resize(n_);
+    double *acc2 = w.acc2[l].data();
+    double *tmp = w.tmp[l].data();
+
+    init(L.op, acc, acc2, n_);
+    for (size_t k = k0; k < k1; ++k) {
+        w.i[L.d] = k;
+        if (l + 1 < levels_.size()) {
+            const level &L1 = levels_[l + 1];
+            if (!reduce(l + 1, L1.k0, L1.k1, w, tmp, false))
+                return false;
+        } else {
+            (*w.fetch)(w.i, tmp);
+            size_t done = ++(*w.done);
+            if (w.progress && std::chrono::steady_clock::now() - w.t0 > progress_interval) {
+                if (!(*w.progress)(done, w.total))
+                    *w.cancel = true;
+                w.t0 = std::chrono::steady_clock::now();
+            }
+            if (*w.cancel)
+                return false;
+        }
+        combine(L.op, tmp, nullptr, acc, acc2, n_, k - k0);
+    }
+    if (!partial)
+        finalize(L.op, acc, acc2, k1 - k0, out, n_);
+    return true;
+}
+
+bool DataReduction::run(const dim_t &i0, const fetch_t &fetch, double *out, const progress_t &progress) const
+{
+    if (levels_.empty()) {
+        fetch(i0, out);
+        return true;
+    }
+
+    const size_t total = count();
+    const size_t k0 = levels_[0].k0;
+    const size_t m0 = levels_[0].k1 - k0;
+    std::atomic<size_t> done{0};
+    std::atomic<bool> cancel{false};
+
+    size_t nthreads = std::min(size_t(maxThreads()), m0);
+    if (total * n_ < min_parallel_size)
+        nthreads = 1;
+
+    if (nthreads == 1) {
+        worker w(i0, levels_.size(), n_);
+        w.fetch = &fetch;
+        w.done = &done;
+        w.cancel = &cancel;
+        if (progress) {
+            w.progress = &progress;
+            w.total = total;
+            w.t0 = std::chrono::steady_clock::now();
+        }
+        bool ret = reduce(0, k0, k0 + m0, w, out, false);
+        if (ret && progress)
+            progress(total, total);
+        return ret;
+    }
+
+    // split the outermost dim among threads
+    std::vector<worker> workers;
+    workers.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; ++t) {
+        workers.emplace_back(i0, levels_.size(), n_);
+        workers.back().fetch = &fetch;
+        workers.back().done = &done;
+        workers.back().cancel = &cancel;
+    }
+
+    std::atomic<size_t> finished{0};
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; ++t) {
+        size_t j0 = k0 + m0 * t / nthreads;
+        size_t j1 = k0 + m0 * (t + 1) / nthreads;
+        threads.emplace_back([this, t, j0, j1, &workers, &finished]() {
+            reduce(0, j0, j1, workers[t], nullptr, true);
+            ++finished;
+        });
+    }
+
+    // report progress from this thread while the workers run
+    while (finished < nthreads) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (progress && !cancel && !progress(done, total))
+            cancel = true;
+    }
+    for (std::thread &th : threads)
+        th.join();
+
+    if (cancel)
+        return false;
+
+    // merge the partial results
+    const op_t op = levels_[0].op;
+    worker &w0 = workers[0];
+    size_t na = m0 / nthreads;
+    for (size_t t = 1; t < nthreads; ++t) {
+        worker &w = workers[t];
+        size_t nb = m0 * (t + 1) / nthreads - m0 * t / nthreads;
+        combine(op,
+                w.acc[0].data(),
+                op == Std ? w.acc2[0].data() : nullptr,
+                w0.acc[0].data(),
+                w0.acc2[0].data(),
+                n_,
+                na,
+                nb);
+        na += nb;
+    }
+    finalize(op, w0.acc[0].data(), w0.acc2[0].data(), m0, out, n_);
+
+    if (progress)
+        progress(total, total);
+    return true;
+}
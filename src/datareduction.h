@@ -0,0 +1,66 @@
+#ifndef DATAREDUCTION_H
+#define DATAREDUCTION_H
+
+#include <functional>
+#include <vector>
+
+// Reduction (sum, mean, min, max, std) of N-D data over some of its dimensions
+//
+// The data is streamed one slice at a time through a fetch function,
+// so that only O(slice size) memory is needed per thread.
+// Reduced dims are processed as nested reductions, in the order they
+// were added, e.g. max over d3 of the sum over d2.
+// The range of the outermost reduced dim is split among worker threads.
+class DataReduction
+{
+public:
+    enum op_t { None = 0, Sum, Mean, Min, Max, Std };
+
+    typedef std::vector<size_t> dim_t;
+    // fill buff with the n values of the slice at offset i0
+    // called concurrently from worker threads
+    typedef std::function<void(const dim_t &i0, double *buff)> fetch_t;
+    // report progress, called from the thread calling run()
+    // return false to cancel
+    typedef std::function<bool(size_t done, size_t total)> progress_t;
+
+    // shape of the data and size of one slice
+    DataReduction(const dim_t &shape, size_t n);
+
+    // reduce dimension d with op over the index range [k0, k1)
+    // by default the whole range of d
+    void add(size_t d, op_t op, size_t k0 = 0, size_t k1 = size_t(-1));
+    bool empty() const { return levels_.empty(); }
+
+    // number of slices to fetch
+    size_t count() const;
+
+    // compute the reduction at offset i0 into out[n]
+    // return false if canceled
+    bool run(const dim_t &i0,
+             const fetch_t &fetch,
+             double *out,
+             const progress_t &progress = progress_t()) const;
+
+    static int maxThreads();
+    static void setMaxThreads(int n);
+
+    static const char *name(op_t op);
+
+private:
+    struct level
+    {
+        size_t d;
+        op_t op;
+        size_t k0, k1;
+    };
+    struct worker;
+
+    dim_t shape_;
+    size_t n_;
+    std::vector<level> levels_;
+
+    bool reduce(size_t l, size_t k0, size_t k1, worker &w, double *out, bool partial) const;
+};
+
+#endif // DATAREDUCTION_H
@@ -2,6 +2,25 @@
 
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+// size a slice buffer keeping its capacity, so that reassignments (e.g.
+// axis changes) reuse it; large buffers grow in whole 2 MiB blocks, so
+// that nearby sizes fit in them too
+template<class T>
+void fit(std::vector<T> &v, size_t n)
+{
+    const size_t block = size_t(2) << 20;
+    const size_t bytes = n * sizeof(T);
+    if (n > v.capacity() && bytes >= block)
+        v.reserve((bytes + block - 1) / block * block / sizeof(T));
+    v.resize(n);
+}
+
+} // namespace
 
 void DataSlice::clear()
 {
@@ -12,37 +31,52 @@ void DataSlice::clear()
     err_.clear();
     x_.clear();
     y_.clear();
-    txtdata_.clear();
-    x_category_.clear();
-    y_category_.clear();
+    txtid_.clear();
+    txtpool_.clear();
+    txtoff_.clear();
+    x_category_.reset();
+    y_category_.reset();
     dim_.clear();
     name_.clear();
     desc_.clear();
     dim_name_.clear();
     dim_desc_.clear();
     D_.clear();
+    reduce_.clear();
+    window_.clear();
+    wsum_.clear();
+    wsum_i0_.clear();
+    changed_rows_.clear();
+    appended_from_ = 0;
+    fetched_version_ = 0;
+    canceled_ = false;
+}
+
+void DataSlice::shrink()
+{
+    data_.shrink_to_fit();
+    wsum_.shrink_to_fit();
+    err_.shrink_to_fit();
+    x_.shrink_to_fit();
+    y_.shrink_to_fit();
+    txtid_.shrink_to_fit();
+    txtpool_.shrink_to_fit();
+    txtoff_.shrink_to_fit();
 }
 
 void DataSlice::assign(const DataStorePtr d, size_t dx, const dim_t &i0)
 {
-    clear();
-    D_ = d;
+    reset_(d);
     dim_idx_ = { dx, 0UL - 1 };
+    reduce_[dx] = DataReduction::None;
+    window_[dx] = 1;
     dim_ = { d->dim()[dx] };
     size_t sz = dim_[0];
-    if (d->is_numeric()) {
-        data_.resize(sz);
-        if (d->hasErrors())
-            err_.resize(sz);
-    } else {
-        txtdata_.resize(sz);
-    }
-    x_.resize(sz);
+    resize_(d, sz);
+    fit(x_, sz);
     d->get_x(dx, x_);
-    if (d->is_x_categorical(dx)) {
-        x_category_.resize(sz);
-        d->get_x_categorical(dx, x_category_);
-    }
+    x_category_ = d->categories(dx);
+    y_category_.reset();
     y_.resize(1);
     y_[0] = 0;
 
@@ -65,31 +99,20 @@ void DataSlice::assign(const DataStorePtr d, size_t dx, const dim_t &i0)
 
 void DataSlice::assign(const DataStorePtr d, size_t dx, size_t dy, const dim_t &i0)
 {
-    clear();
-    D_ = d;
+    reset_(d);
     dim_idx_ = { dx, dy };
+    reduce_[dx] = DataReduction::None;
+    reduce_[dy] = DataReduction::None;
+    window_[dx] = window_[dy] = 1;
 
     dim_ = { d->dim()[dx], d->dim()[dy] };
-    size_t sz = dim_[0] * dim_[1];
-    if (d->is_numeric()) {
-        data_.resize(sz);
-        if (d->hasErrors())
-            err_.resize(sz);
-    } else {
-        txtdata_.resize(sz);
-    }
-    x_.resize(dim_[0]);
+    resize_(d, dim_[0] * dim_[1]);
+    fit(x_, dim_[0]);
     d->get_x(dx, x_);
-    if (d->is_x_categorical(dx)) {
-        x_category_.resize(dim_[0]);
-        d->get_x_categorical(dx, x_category_);
-    }
-    y_.resize(dim_[1]);
+    x_category_ = d->categories(dx);
+    fit(y_, dim_[1]);
     d->get_x(dy, y_);
-    if (d->is_x_categorical(dy)) {
-        y_category_.resize(dim_[1]);
-        d->get_x_categorical(dy, y_category_);
-    }
+    y_category_ = d->categories(dy);
 
     assign_(i0);
 
@@ -145,14 +168,294 @@ void DataSlice::assign(const DataStorePtr d, size_t dims)
 void DataSlice::assign(const dim_t &new_i0)
 {
     assert(i0_.size() == new_i0.size());
-    assign_(new_i0);
+    assign_(new_i0, true);
 }
 
 void DataSlice::update()
 {
+    // a change of unknown extent: only the tail is read if the store only
+    // ever appends along x; with the same shape all rows are read & only
+    // those that differ are reported; otherwise the slice is read anew
+    DataStorePtr d = D_.lock();
+    if (d && ndim() == 1 && d->is_append_only(dx()) && append_(d))
+        return;
+    if (d && update_rows_(d, 0, ndim() > 1 ? dim_[1] : 1))
+        return;
     assign_(i0_);
 }
 
+void DataSlice::update(size_t k, size_t from, size_t to)
+{
+    DataStorePtr d = D_.lock();
+    if (!d || empty() || k >= i0_.size() || !d->is_numeric() || is_reduced()) {
+        update();
+        return;
+    }
+    if (k != dx() && (ndim() == 1 || k != dy())) {
+        if (i0_[k] >= from && i0_[k] < to) {
+            update();
+            return;
+        }
+        // a hidden dim & the slice is outside the range
+        changed_rows_.clear();
+        appended_from_ = ndim() == 1 ? dim_[0] : 0;
+        return;
+    }
+    if (ndim() > 1 && k == dy() && update_rows_(d, from, to))
+        return;
+    // exactly the values after the end of a 1D slice
+    if (ndim() == 1 && k == dx() && from == dim_[0] && to == d->dim()[k] && append_(d))
+        return;
+    update();
+}
+
+DataSlice::frame_reader DataSlice::reader() const
+{
+    frame_reader r;
+    DataStorePtr d = D_.lock();
+    if (!d || !d->is_numeric() || empty() || is_reduced())
+        return r;
+    r.D = d;
+    r.shape = d->dim();
+    r.dim = dim_;
+    r.dx = dx();
+    r.dy = ndim() > 1 ? dy() : dx();
+    r.errors = d->hasErrors();
+    r.layout = d->layout();
+    return r;
+}
+
+bool DataSlice::frame_reader::fetch(const dim_t &i0, vec_t &y, vec_t &e) const
+{
+    if (!D || i0.size() != shape.size())
+        return false;
+    for (size_t k = 0; k < i0.size(); ++k)
+        if (i0[k] >= shape[k])
+            return false;
+    auto lock = D->lock_layout();
+    if (D->layout() != layout || (layout & 1))
+        return false;
+    dim_t j(i0);
+    j[dx] = 0;
+    j[dy] = 0;
+    size_t n = dim[0] * (dim.size() > 1 ? dim[1] : 1);
+    y.resize(n);
+    e.resize(errors ? n : 0);
+    D->read_consistent([&]() { read_(*D, dim, dx, dy, j, y.data(), e.empty() ? nullptr : e.data()); });
+    return true;
+}
+
+void DataSlice::set_frame(const dim_t &i0, vec_t &y, vec_t &e)
+{
+    if (y.size() != data_.size() || e.size() != err_.size())
+        return;
+    i0_ = i0;
+    i0_[dx()] = 0;
+    if (ndim() > 1)
+        i0_[dy()] = 0;
+    data_.swap(y);
+    err_.swap(e);
+    changed_rows_ = {{0, ndim() > 1 ? dim_[1] : 1}};
+    appended_from_ = 0;
+    // read concurrently, at an unknown version
+    fetched_version_ = 0;
+}
+
+bool DataSlice::is_current() const
+{
+    DataStorePtr d = D_.lock();
+    return d && fetched_version_ && !(fetched_version_ & 1) && d->version() == fetched_version_;
+}
+
+bool DataSlice::all_rows_changed() const
+{
+    size_t ny = ndim() > 1 ? dim_[1] : 1;
+    return changed_rows_.size() == 1 && changed_rows_[0].first == 0
+           && changed_rows_[0].second == ny;
+}
+
+// a 1D slice of data that grew along x: read only the new values
+// called only when the existing values are known to be unchanged, i.e.
+// the update range is the new tail or the store is append-only along x
+bool DataSlice::append_(const DataStorePtr &d)
+{
+    if (ndim() != 1 || !d->is_numeric() || data_.empty() || is_reduced()
+        || d->hasErrors() != hasErrors() || d->ndim() != i0_.size())
+        return false;
+    const size_t n0 = dim_[0], n1 = d->dim()[dx()];
+    if (n1 <= n0)
+        return false;
+    for (size_t k = 0; k < i0_.size(); ++k)
+        if (k != dx() && i0_[k] >= d->dim()[k])
+            return false;
+
+    const size_t m = n1 - n0;
+    const uint64_t v = d->version();
+    dim_t j(i0_);
+    j[dx()] = n0;
+    dim_[0] = n1;
+    data_.resize(n1);
+    if (!err_.empty())
+        err_.resize(n1);
+    bool consistent = d->read_consistent([&]() {
+        d->get_y(dx(), j, m, data_.data() + n0);
+        if (!err_.empty())
+            d->get_dy(dx(), j, m, err_.data() + n0);
+    });
+    x_.resize(n1);
+    d->get_x(dx(), n0, m, x_.data() + n0);
+    x_category_ = d->categories(dx());
+
+    changed_rows_ = {{0, 1}};
+    appended_from_ = n0;
+    fetched_version_ = consistent ? v : 0;
+    return true;
+}
+
+// re-read the data row by row & copy only the rows that changed
+// only the rows [j0, j1) if given
+// return false if not possible, e.g. for reduced slices
+bool DataSlice::update_rows_(const DataStorePtr &d, size_t j0, size_t j1)
+{
+    if (!d->is_numeric() || data_.empty() || is_reduced() || d->hasErrors() != hasErrors())
+        return false;
+    for (int i = 0; i < ndim(); ++i)
+        if (d->dim()[dim_idx_[i]] != dim_[i])
+            return false;
+
+    const size_t nx = dim_[0];
+    const size_t ny = ndim() > 1 ? dim_[1] : 1;
+    j1 = std::min(j1, ny);
+    const uint64_t v = d->version();
+    vec_t buff(nx), ebuff(err_.empty() ? 0 : nx);
+    dim_t i1(i0_);
+    // rows copied by any of the attempts of a consistent read
+    std::vector<char> changed(ny, 0);
+    bool consistent = d->read_consistent([&]() {
+        for (size_t j = j0; j < j1; ++j) {
+            if (ndim() > 1)
+                i1[dy()] = j;
+            d->get_y(dx(), i1, nx, buff.data());
+            double *y = data_.data() + j * nx;
+            if (std::memcmp(buff.data(), y, nx * sizeof(double)) != 0) {
+                std::copy(buff.begin(), buff.end(), y);
+                changed[j] = 1;
+            }
+            if (!ebuff.empty()) {
+                d->get_dy(dx(), i1, nx, ebuff.data());
+                double *e = err_.data() + j * nx;
+                if (std::memcmp(ebuff.data(), e, nx * sizeof(double)) != 0) {
+                    std::copy(ebuff.begin(), ebuff.end(), e);
+                    changed[j] = 1;
+                }
+            }
+        }
+    });
+
+    changed_rows_.clear();
+    appended_from_ = 0;
+    for (size_t j = j0; j < j1; ++j) {
+        if (!changed[j])
+            continue;
+        if (!changed_rows_.empty() && changed_rows_.back().second == j)
+            changed_rows_.back().second = j + 1;
+        else
+            changed_rows_.push_back({j, j + 1});
+    }
+    // nothing changed: as if an empty tail was appended
+    if (changed_rows_.empty() && ndim() == 1)
+        appended_from_ = nx;
+    // the version applies to the whole slice only
+    fetched_version_ = consistent && j0 == 0 && j1 == ny ? v : 0;
+    return true;
+}
+
+void DataSlice::set_reduction(size_t d, DataReduction::op_t op)
+{
+    if (d < reduce_.size() && d != dim_idx_[0] && (ndim() < 2 || d != dim_idx_[1])) {
+        reduce_[d] = op;
+        fetched_version_ = 0;
+    }
+}
+
+void DataSlice::set_window(size_t d, size_t w)
+{
+    if (d < window_.size() && d != dim_idx_[0] && (ndim() < 2 || d != dim_idx_[1])) {
+        DataStorePtr D = D_.lock();
+        window_[d] = D ? std::max(std::min(w, D->dim()[d]), size_t(1)) : 1;
+        wsum_.clear();
+        fetched_version_ = 0;
+    }
+}
+
+bool DataSlice::is_reduced() const
+{
+    for (size_t d = 0; d < reduce_.size(); ++d) {
+        if (reduce_[d] != DataReduction::None || window_[d] > 1)
+            return true;
+    }
+    return false;
+}
+
+// the dim with an averaging window, if there is exactly one
+// otherwise -1
+size_t DataSlice::window_dim_() const
+{
+    size_t wd = size_t(-1);
+    for (size_t d = 0; d < window_.size(); ++d) {
+        if (window_[d] > 1 && reduce_[d] == DataReduction::None) {
+            if (wd != size_t(-1))
+                return size_t(-1);
+            wd = d;
+        }
+    }
+    return wd;
+}
+
+// reset the slice for an assignment of d, keeping the reductions if it
+// is the same data store; the buffers keep their capacity & contents
+void DataSlice::reset_(const DataStorePtr &d)
+{
+    if (D_.lock() != d) {
+        reduce_.clear();
+        window_.clear();
+    }
+    dim_idx_.clear();
+    dim_order_.clear();
+    i0_.clear();
+    dim_.clear();
+    name_.clear();
+    desc_.clear();
+    dim_name_.clear();
+    dim_desc_.clear();
+    wsum_.clear();
+    wsum_i0_.clear();
+    changed_rows_.clear();
+    appended_from_ = 0;
+    fetched_version_ = 0;
+    canceled_ = false;
+    D_ = d;
+    reduce_.resize(d->ndim(), DataReduction::None);
+    window_.resize(d->ndim(), 1);
+}
+
+// size the data buffers for sz values, all values are then read
+void DataSlice::resize_(const DataStorePtr &d, size_t sz)
+{
+    if (d->is_numeric()) {
+        fit(data_, sz);
+        if (d->hasErrors())
+            fit(err_, sz);
+        txtid_.clear();
+        txtpool_.clear();
+        txtoff_.clear();
+    } else {
+        data_.clear();
+        err_.clear();
+        fit(txtid_, sz);
+    }
+}
+
 void DataSlice::export_csv(std::ostream &os)
 {
     if (empty())
@@ -162,29 +465,30 @@ void DataSlice::export_csv(std::ostream &os)
         if (ndim() == 1) {
             os << "x,y" << std::endl;
             for (size_t i = 0; i < dim_[0]; ++i) {
-                if (!x_category_.empty())
-                    os << std::quoted(x_category_[i]) << ", ";
+                if (x_category_)
+                    os << std::quoted((*x_category_)[i]) << ", ";
                 else
                     os << x_[i] << ", ";
-                os << std::quoted(txtdata_[i]) << std::endl;
+                os << std::quoted(text_data(i, 0)) << std::endl;
             }
         } else {
             for (size_t i = 0; i < dim_[0]; ++i) {
-                os << std::quoted(txtdata_[i]);
+                os << std::quoted(text_data(i, 0));
                 for (size_t j = 1; j < dim_[1]; ++j) {
-                    os << ", " << std::quoted(txtdata_[i + j * dim_[0]]);
+                    os << ", " << std::quoted(text_data(i, j));
                 }
                 os << std::endl;
             }
         }
+        return;
     }
 
     if (hasErrors()) {
         if (ndim() == 1) {
             os << "x,y,dy" << std::endl;
             for (size_t i = 0; i < dim_[0]; ++i) {
-                if (!x_category_.empty())
-                    os << std::quoted(x_category_[i]) << ", ";
+                if (x_category_)
+                    os << std::quoted((*x_category_)[i]) << ", ";
                 else
                     os << x_[i] << ", ";
                 os << data_[i] << ", ";
@@ -204,8 +508,8 @@ void DataSlice::export_csv(std::ostream &os)
         if (ndim() == 1) {
             os << "x,y" << std::endl;
             for (size_t i = 0; i < dim_[0]; ++i) {
-                if (!x_category_.empty())
-                    os << std::quoted(x_category_[i]) << ", ";
+                if (x_category_)
+                    os << std::quoted((*x_category_)[i]) << ", ";
                 else
                     os << x_[i] << ", ";
                 os << data_[i] << std::endl;
@@ -222,6 +526,31 @@ void DataSlice::export_csv(std::ostream &os)
     }
 }
 
+DataSlice::buffer_usage_t DataSlice::buffer_usage() const
+{
+    buffer_usage_t u;
+    u.data = memoryUsage(data_) + memoryUsage(wsum_);
+    u.errors = memoryUsage(err_);
+    u.axes = memoryUsage(x_) + memoryUsage(y_);
+    u.text = memoryUsage(txtid_) + memoryUsage(txtpool_) + memoryUsage(txtoff_);
+    // shared with the data store
+    u.categories = memoryUsage(x_category()) + memoryUsage(y_category());
+    return u;
+}
+
+size_t DataSlice::unused_capacity() const
+{
+    size_t n = (data_.capacity() - data_.size()) + (err_.capacity() - err_.size())
+               + (x_.capacity() - x_.size()) + (y_.capacity() - y_.size());
+    n *= sizeof(double);
+    n += (txtid_.capacity() - txtid_.size()) * sizeof(uint32_t)
+         + (txtoff_.capacity() - txtoff_.size()) * sizeof(size_t);
+    // the pool's own small buffer is not heap memory
+    if (memoryUsage(txtpool_))
+        n += txtpool_.capacity() - txtpool_.size();
+    return n;
+}
+
 size_t DataSlice::_get_(size_t d, const dim_t &i0, const vec_t &yy, size_t n, double *v) const
 {
     if (ndim() == 1) {
@@ -240,7 +569,7 @@ size_t DataSlice::_get_(size_t d, const dim_t &i0, const vec_t &yy, size_t n, do
     return m;
 }
 
-void DataSlice::assign_(const dim_t &new_i0)
+void DataSlice::assign_(const dim_t &new_i0, bool incremental)
 {
     DataStorePtr d = D_.lock();
     if (!d) { // data pointer has been deleted
@@ -249,50 +578,207 @@ void DataSlice::assign_(const dim_t &new_i0)
     }
 
     i0_ = new_i0;
+    // read before the data, a write meanwhile changes it
+    fetched_version_ = d->version();
 
     if (!d->is_numeric()) {
-        if (ndim() == 1) {
-            i0_[dx()] = 0;
-            d->get_y_text(dx(), i0_, txtdata_);
-        } else {
-            i0_[dx()] = 0;
+        i0_[dx()] = 0;
+        if (ndim() > 1)
             i0_[dy()] = 0;
-            dim_t j1(i0_);
-            // copy row-by-row [column-major storage]
-            int k = 0;
-            strvec_t buff(dim_[0]);
-            for (size_t i = 0; i < dim_[1]; ++i) {
-                j1[dy()] = i;
-                d->get_y_text(dx(), j1, buff);
-                for (auto it = buff.begin(); it != buff.end(); ++it, ++k)
-                    txtdata_[k] = *it;
-            }
-        }
+        read_text_(d);
         return;
     }
 
-    bool withErrors = d->hasErrors();
-    if (ndim() == 1) {
-        i0_[dx()] = 0;
-        d->get_y(dx(), i0_, dim_[0], data_.data());
-        if (d->hasErrors()) {
-            d->get_dy(dx(), i0_, dim_[0], err_.data());
+    bool reduced = is_reduced();
+    // errors are not propagated through reductions
+    if (d->hasErrors() && !reduced)
+        fit(err_, data_.size());
+    else
+        err_.clear();
+
+    i0_[dx()] = 0;
+    if (ndim() > 1)
+        i0_[dy()] = 0;
+
+    canceled_ = false;
+    if (reduced) {
+        if (!compute_reduced_(d, incremental)) {
+            canceled_ = true;
+            fetched_version_ = 0;
+            wsum_.clear();
+            std::fill(data_.begin(), data_.end(), std::numeric_limits<double>::quiet_NaN());
         }
     } else {
-        i0_[dx()] = 0;
-        i0_[dy()] = 0;
-        double *p = data_.data();
-        double *dp = withErrors ? err_.data() : nullptr;
-        dim_t j1(i0_);
-        // copy row-by-row [column-major storage]
-        for (size_t i = 0; i < dim_[1]; ++i) {
+        if (!d->read_consistent([&]() { fetch_(d, i0_, data_.data(), err_.empty() ? nullptr : err_.data()); }))
+            fetched_version_ = 0;
+    }
+    changed_rows_ = {{0, ndim() > 1 ? dim_[1] : 1}};
+    appended_from_ = 0;
+}
+
+// read the text values row-by-row [column-major storage] & intern them
+// the strings are moved from the row buffer into the index and copied
+// once into the pool
+void DataSlice::read_text_(const DataStorePtr &d)
+{
+    const size_t ny = ndim() > 1 ? dim_[1] : 1;
+    std::unordered_map<std::string, uint32_t> index;
+    index.reserve(std::min(txtid_.size(), size_t(1024)));
+    strvec_t buff(dim_[0]);
+    dim_t j1(i0_);
+    uint32_t *id = txtid_.data();
+    for (size_t i = 0; i < ny; ++i) {
+        if (ndim() > 1)
             j1[dy()] = i;
-            d->get_y(dx(), j1, dim_[0], p);
-            p += dim_[0];
-            if (withErrors) {
-                d->get_dy(dx(), i0_, dim_[0], dp);
-                dp += dim_[0];
-            }
+        d->get_y_text(dx(), j1, buff);
+        for (std::string &t : buff)
+            *id++ = index.try_emplace(std::move(t), uint32_t(index.size())).first->second;
+    }
+
+    std::vector<const std::string *> byId(index.size());
+    size_t n = 0;
+    for (const auto &e : index) {
+        byId[e.second] = &e.first;
+        n += e.first.size();
+    }
+    txtpool_.clear();
+    txtpool_.reserve(n);
+    txtoff_.resize(byId.size() + 1);
+    for (size_t k = 0; k < byId.size(); ++k) {
+        txtoff_[k] = txtpool_.size();
+        txtpool_ += *byId[k];
+    }
+    txtoff_.back() = txtpool_.size();
+}
+
+// compute the reductions & window averages of the hidden dims
+// return false if canceled
+bool DataSlice::compute_reduced_(const DataStorePtr &d, bool incremental)
+{
+    // keep the windows inside the data
+    for (size_t k = 0; k < window_.size(); ++k) {
+        if (window_[k] > 1)
+            i0_[k] = std::min(i0_[k], d->dim()[k] - window_[k]);
+    }
+
+    if (incremental && window_step_(d))
+        return true;
+
+    auto fetch = [this, d](const dim_t &i0, double *buff) { fetch_(d, i0, buff, nullptr); };
+
+    // window averages are the outermost levels
+    // a single window is kept as a running sum for incremental updates
+    size_t wd = window_dim_();
+    DataReduction R(d->dim(), data_.size());
+    for (size_t k = 0; k < window_.size(); ++k) {
+        if (window_[k] > 1 && reduce_[k] == DataReduction::None)
+            R.add(k, k == wd ? DataReduction::Sum : DataReduction::Mean, i0_[k], i0_[k] + window_[k]);
+    }
+    for (size_t k = 0; k < reduce_.size(); ++k)
+        R.add(k, reduce_[k]);
+
+    if (wd == size_t(-1)) {
+        wsum_.clear();
+        return R.run(i0_, fetch, data_.data(), progress_);
+    }
+
+    wsum_.resize(data_.size());
+    if (!R.run(i0_, fetch, wsum_.data(), progress_))
+        return false;
+    wsum_i0_ = i0_;
+    wsteps_ = 0;
+    const double f = 1.0 / window_[wd];
+    for (size_t i = 0; i < data_.size(); ++i)
+        data_[i] = wsum_[i] * f;
+    return true;
+}
+
+// move a single averaging window by adding the entering & subtracting the
+// leaving slices from the running sum
+// return false if this is not possible & a full computation is needed
+bool DataSlice::window_step_(const DataStorePtr &d)
+{
+    // full recompute after this many steps to limit round-off accumulation
+    const size_t max_window_steps = 1024;
+
+    size_t wd = window_dim_();
+    if (wd == size_t(-1) || wsum_.size() != data_.size() || wsteps_ >= max_window_steps)
+        return false;
+    for (size_t k = 0; k < i0_.size(); ++k) {
+        if (k != wd && i0_[k] != wsum_i0_[k])
+            return false;
+    }
+
+    const size_t w = window_[wd];
+    const size_t a = wsum_i0_[wd], b = i0_[wd];
+    const size_t delta = a < b ? b - a : a - b;
+    if (delta >= w)
+        return false;
+
+    // reductions of the other hidden dims, computed for each slice
+    DataReduction R(d->dim(), data_.size());
+    for (size_t k = 0; k < reduce_.size(); ++k)
+        R.add(k, reduce_[k]);
+    auto fetch = [this, d](const dim_t &i0, double *buff) { fetch_(d, i0, buff, nullptr); };
+
+    const size_t n = data_.size();
+    vec_t buff(n);
+    dim_t j(i0_);
+    const size_t leave0 = a < b ? a : b + w;
+    const size_t enter0 = a < b ? a + w : b;
+    for (size_t k = 0; k < delta; ++k) {
+        j[wd] = leave0 + k;
+        if (!R.run(j, fetch, buff.data(), progress_))
+            return false;
+        for (size_t i = 0; i < n; ++i)
+            wsum_[i] -= buff[i];
+        j[wd] = enter0 + k;
+        if (!R.run(j, fetch, buff.data(), progress_))
+            return false;
+        for (size_t i = 0; i < n; ++i)
+            wsum_[i] += buff[i];
+    }
+    wsum_i0_ = i0_;
+    wsteps_ += delta;
+
+    const double f = 1.0 / w;
+    for (size_t i = 0; i < n; ++i)
+        data_[i] = wsum_[i] * f;
+    return true;
+}
+
+// copy the slice at offset i0 from d to y and (if not null) its errors to e
+// may be called concurrently from worker threads
+void DataSlice::fetch_(const DataStorePtr &d, const dim_t &i0, double *y, double *e) const
+{
+    read_(*d, dim_, dx(), ndim() > 1 ? dy() : dx(), i0, y, e);
+}
+
+// the same for a slice of dims dim along dx, dy of d
+void DataSlice::read_(const AbstractDataStore &d,
+                      const dim_t &dim,
+                      size_t dx,
+                      size_t dy,
+                      const dim_t &i0,
+                      double *y,
+                      double *e)
+{
+    if (dim.size() == 1) {
+        d.get_y(dx, i0, dim[0], y);
+        if (e)
+            d.get_dy(dx, i0, dim[0], e);
+        return;
+    }
+
+    dim_t j1(i0);
+    // copy row-by-row [column-major storage]
+    for (size_t i = 0; i < dim[1]; ++i) {
+        j1[dy] = i;
+        d.get_y(dx, j1, dim[0], y);
+        y += dim[0];
+        if (e) {
+            d.get_dy(dx, j1, dim[0], e);
+            e += dim[0];
         }
     }
 }
@@ -305,3 +791,15 @@ size_t DataSlice::get_x(size_t d, size_t n, double *v) const
         std::memcpy(v, z.data(), m * sizeof(double));
     return m;
 }
+
+bool hasSingletonDim(const DataStorePtr d)
+{
+    if (d->empty())
+        return false;
+    for (size_t d : d->dim())
+    {
+        if (d == 1)
+            return true;
+    }
+    return false;
+}
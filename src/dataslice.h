@@ -1,10 +1,14 @@
 #ifndef DATASLICE_H
 #define DATASLICE_H
 
+#include "datareduction.h"
+#include "memoryaccount.h"
 #include "qdatabrowser.h"
 
 #include <QSharedPointer>
+#include <cstdint>
 #include <cstring>
+#include <string_view>
 
 typedef QSharedPointer<AbstractDataStore> DataStorePtr;
 
@@ -20,17 +24,21 @@ public:
     bool is_x_categorical(size_t d) const override
     {
         if (d == 0)
-            return !x_category_.empty();
+            return x_category_ != nullptr;
         if (d == 1)
-            return !y_category_.empty();
+            return y_category_ != nullptr;
         return false;
     }
 
     size_t get_x_categorical(size_t d, strvec_t &categories) const override
     {
-        categories = (d == 0) ? x_category_ : y_category_;
+        categories = (d == 0) ? x_category() : y_category();
         return categories.size();
     }
+    categories_t categories(size_t d) const override
+    {
+        return d == 0 ? x_category_ : (d == 1 ? y_category_ : categories_t());
+    }
 
     const dim_t &i0() const { return i0_; }
     const dim_t &dim_order() const { return dim_order_; }
@@ -39,33 +47,134 @@ public:
 
     const vec_t &x() const { return x_; }
     const vec_t &y() const { return y_; }
-    const strvec_t &x_category() const { return x_category_; }
-    const strvec_t &y_category() const { return y_category_; }
+    // the categories of the data store, empty if not categorical
+    const strvec_t &x_category() const { return x_category_ ? *x_category_ : no_categories_(); }
+    const strvec_t &y_category() const { return y_category_ ? *y_category_ : no_categories_(); }
     const vec_t &data() const { return data_; }
     const vec_t &errors() const { return err_; }
     double x(int i) const { return x_[i]; }
     double y(int i) const { return y_[i]; }
     double operator()(size_t i) const { return data_[i]; }
     double operator()(size_t i, size_t j) const { return data_[i + j * dim_[0]]; }
-    const std::string &text_data(size_t i, size_t j) const { return txtdata_[i + j * dim_[0]]; }
+    // text data are interned: each value is the id of a string in a pool
+    // of the distinct values of the slice
+    std::string_view text_data(size_t i, size_t j) const { return text(text_id(i, j)); }
+    uint32_t text_id(size_t i, size_t j) const { return txtid_[i + j * dim_[0]]; }
+    std::string_view text(uint32_t id) const
+    {
+        return std::string_view(txtpool_.data() + txtoff_[id], txtoff_[id + 1] - txtoff_[id]);
+    }
+    // number of distinct text values
+    size_t text_count() const { return txtoff_.empty() ? 0 : txtoff_.size() - 1; }
 
     void clear();
+    // release unused buffer capacity
+    void shrink();
     void assign(const DataStorePtr d, size_t dx, const dim_t &i0);
     void assign(const DataStorePtr d, size_t dx, size_t dy, const dim_t &i0);
     void assign(const DataStorePtr d, size_t dims = 2);
     void assign(const dim_t &new_i0);
+    // update after a change of unknown extent, the rows that differ are
+    // reported by changed_rows()
     void update();
+    // update after values changed in place at indexes [from, to) of dim d
+    // of the data store: nothing is read if the slice is outside the range,
+    // only the rows in the range if d is the y dim
+    void update(size_t d, size_t from, size_t to);
+
+    // Numeric, not reduced slices are read with read_consistent(), so
+    // they never hold a frame torn by a concurrent write of the store.
+    // Reductions read the data many times & are not retried.
+
+    // version of the data store when the slice was read, 0 if unknown
+    uint64_t fetched_version() const { return fetched_version_; }
+    // the data store tracks its changes & did not change since then
+    bool is_current() const;
+
+    // frames for playback: a copy of what is needed to read the slice
+    // at other offsets, so that worker threads never touch the slice,
+    // which may be updated or reassigned meanwhile in the GUI thread
+    struct frame_reader
+    {
+        DataStorePtr D;       // null if the slice has no frames
+        dim_t shape;          // of D
+        dim_t dim;            // of the slice
+        size_t dx{0}, dy{0};
+        bool errors{false};
+        uint64_t layout{0};   // of D
+
+        // read the frame at offset i0, safe to call concurrently
+        // false if D was resized since the reader was made
+        bool fetch(const dim_t &i0, vec_t &y, vec_t &e) const;
+    };
+    // an empty reader for reduced, text or empty slices
+    frame_reader reader() const;
+    // read the slice at another offset without changing it
+    bool fetch(const dim_t &i0, vec_t &y, vec_t &e) const { return reader().fetch(i0, y, e); }
+    // show a fetched frame, swapping its buffers with the slice data
+    void set_frame(const dim_t &i0, vec_t &y, vec_t &e);
+
+    // rows (index along the 2nd slice dim) whose values changed in the
+    // last update(), as [j0, j1) ranges; all rows after an assign
+    typedef std::vector<std::pair<size_t, size_t>> ranges_t;
+    const ranges_t &changed_rows() const { return changed_rows_; }
+    bool all_rows_changed() const;
+    // 1D slices: values before this index were kept by the last update(),
+    // which only appended the rest because the data grew along x
+    // 0 after an assign or any other change
+    size_t appended_from() const { return appended_from_; }
+
+    // reduction of the hidden (not x/y) dims of the data store
+    // update() must be called for the change to take effect
+    DataReduction::op_t reduction(size_t d) const
+    {
+        return d < reduce_.size() ? reduce_[d] : DataReduction::None;
+    }
+    void set_reduction(size_t d, DataReduction::op_t op);
+    // averaging window [i0, i0 + w) along a hidden dim, w = 1 for no window
+    // update() must be called for the change to take effect
+    size_t window(size_t d) const { return d < window_.size() ? window_[d] : 1; }
+    void set_window(size_t d, size_t w);
+    // true if any hidden dim is reduced or averaged over a window
+    bool is_reduced() const;
+    // called periodically during long reductions, return false to cancel
+    void set_progress(const DataReduction::progress_t &f) { progress_ = f; }
+    // true if the last update was canceled, data are then NaN
+    bool canceled() const { return canceled_; }
 
     void export_csv(std::ostream &os);
 
+    // bytes held by the slice buffers
+    struct buffer_usage_t
+    {
+        size_t data{0}, errors{0}, axes{0}, text{0}, categories{0};
+        size_t total() const { return data + errors + axes + text + categories; }
+    };
+    buffer_usage_t buffer_usage() const;
+    // bytes held by the buffers in excess of the slice size
+    size_t unused_capacity() const;
+    size_t memory_usage() const override { return buffer_usage().total(); }
+
 protected:
     dim_t dim_idx_;                    // slice x & y dimensions
     dim_t dim_order_;                  // order of D_ dimensions
     dim_t i0_;                         // offset into D_
     vec_t data_, err_, x_, y_;         // slice data
-    strvec_t txtdata_;                 // text data
-    strvec_t x_category_, y_category_; // category data for x & y
+    std::vector<uint32_t> txtid_;      // text data, ids of the values
+    std::string txtpool_;              // distinct text values, concatenated
+    std::vector<size_t> txtoff_;       // offset of each text value in the pool & the end
+    categories_t x_category_, y_category_; // category data for x & y, shared with D_
     QWeakPointer<AbstractDataStore> D_;
+    std::vector<DataReduction::op_t> reduce_; // reduction op per D_ dimension
+    dim_t window_;                            // averaging window per D_ dimension
+    vec_t wsum_;                              // running sum over a single window
+    dim_t wsum_i0_;                           // offset of the running sum
+    size_t wsteps_{0};                        // incremental steps since the last full sum
+    ranges_t changed_rows_;                   // rows changed by the last update
+    size_t appended_from_{0};                 // 1st value appended by the last update
+    uint64_t fetched_version_{0};             // data store version read by the last full read
+    DataReduction::progress_t progress_;
+    bool canceled_{false};
 
     size_t _get_(size_t d, const dim_t &i0, const vec_t &yy, size_t n, double *v) const;
 
@@ -79,9 +188,164 @@ protected:
     }
     virtual size_t get_x(size_t d, size_t n, double *v) const override;
 
-    void assign_(const dim_t &new_i0);
+    void assign_(const dim_t &new_i0, bool incremental = false);
+    bool compute_reduced_(const DataStorePtr &d, bool incremental);
+    bool window_step_(const DataStorePtr &d);
+    size_t window_dim_() const;
+    void fetch_(const DataStorePtr &d, const dim_t &i0, double *y, double *dy) const;
+    static void read_(const AbstractDataStore &d,
+                      const dim_t &dim,
+                      size_t dx,
+                      size_t dy,
+                      const dim_t &i0,
+                      double *y,
+                      double *e);
+    bool update_rows_(const DataStorePtr &d, size_t j0 = 0, size_t j1 = size_t(-1));
+    bool append_(const DataStorePtr &d);
+    void reset_(const DataStorePtr &d);
+    void resize_(const DataStorePtr &d, size_t sz);
+    void read_text_(const DataStorePtr &d);
+    static const strvec_t &no_categories_()
+    {
+        static const strvec_t none;
+        return none;
+    }
+};
+
+// A proxy data store that hides the singleton dims (size=1) of the
+// wrapped data
+class SqueezedDataStore : public AbstractDataStore
+{
+public:
+    SqueezedDataStore(const DataStorePtr d)
+        : D_(d)
+    {
+        name_ = d->name();
+        desc_ = d->description();
+        if (!d->empty())
+        {
+            if (d->size() == 1)
+            { // scalar
+                dim_ = {1};
+                dim_name_ = {d->dim_name(0)};
+                dim_desc_ = {d->dim_desc(0)};
+                dim_idx_ = {0};
+            }
+            else
+            {
+                for (int i = 0; i < d->dim().size(); ++i)
+                {
+                    size_t n = d->dim()[i];
+                    if (n > 1)
+                    {
+                        dim_.push_back(n);
+                        dim_idx_.push_back(i);
+                        dim_name_.push_back(d->dim_name(i));
+                        dim_desc_.push_back(d->dim_desc(i));
+                    }
+                }
+            }
+        }
+    }
+    virtual ~SqueezedDataStore() {}
+
+    bool is_numeric() const override { return D_.isNull() ? true : D_.lock()->is_numeric(); }
+    bool hasErrors() const override { return D_.isNull() ? false : D_.lock()->hasErrors(); }
+    bool is_x_categorical(size_t d) const override
+    {
+        return D_.isNull() ? false : D_.lock()->is_x_categorical(dim_idx_[d]);
+    }
+    size_t get_y_text(size_t d, const dim_t &i0, strvec_t &y) const override
+    {
+        return D_.isNull() ? 0 : D_.lock()->get_y_text(dim_idx_[d], i1(i0), y);
+    }
+    bool is_append_only(size_t d) const override
+    {
+        return D_.isNull() ? false : D_.lock()->is_append_only(dim_idx_[d]);
+    }
+    size_t get_x_categorical(size_t d, strvec_t &x) const override
+    {
+        return D_.isNull() ? 0 : D_.lock()->get_x_categorical(dim_idx_[d], x);
+    }
+    categories_t categories(size_t d) const override
+    {
+        return D_.isNull() ? categories_t() : D_.lock()->categories(dim_idx_[d]);
+    }
+    uint64_t version() const override { return D_.isNull() ? 0 : D_.lock()->version(); }
+    // the original store is the one resized
+    uint64_t layout() const override { return D_.isNull() ? 0 : D_.lock()->layout(); }
+    std::shared_lock<std::shared_mutex> lock_layout() const override
+    {
+        DataStorePtr p = D_.lock();
+        return p ? p->lock_layout() : AbstractDataStore::lock_layout();
+    }
+    size_t memory_usage() const override
+    {
+        return sizeof(*this) + memoryUsage(dim_) + memoryUsage(dim_idx_) + memoryUsage(dim_name_)
+               + memoryUsage(dim_desc_);
+    }
+
+protected:
+    QWeakPointer<AbstractDataStore> D_;
+    dim_t dim_idx_;
+
+    // expand a pointer to squeezed data (i0) to a pointer to original data (i1)
+    dim_t i1(const dim_t &i0) const
+    {
+        dim_t i1_(D_.lock()->ndim(), 0);
+        for (int i = 0; i < ndim(); ++i)
+            i1_[dim_idx_[i]] = i0[i];
+        return i1_;
+    }
+
+    size_t get_y(size_t d, const dim_t &i0, size_t n, double *v) const override
+    {
+        if (D_.isNull())
+            return 0;
+        DataStorePtr p = D_.lock();
+        std::vector<double> buff(n);
+        int m = p->get_y(dim_idx_[d], i1(i0), buff);
+        std::copy(buff.begin(), buff.begin() + m, v);
+        return m;
+    }
+    size_t get_dy(size_t d, const dim_t &i0, size_t n, double *v) const override
+    {
+        if (D_.isNull())
+            return 0;
+        DataStorePtr p = D_.lock();
+        std::vector<double> buff(n);
+        int m = p->get_dy(dim_idx_[d], i1(i0), buff);
+        std::copy(buff.begin(), buff.begin() + m, v);
+        return m;
+    }
+    size_t get_x(size_t d, size_t n, double *v) const override
+    {
+        if (D_.isNull())
+            return 0;
+        DataStorePtr p = D_.lock();
+        std::vector<double> buff(n);
+        int m = p->get_x(dim_idx_[d], buff);
+        std::copy(buff.begin(), buff.begin() + m, v);
+        return m;
+    }
+    size_t get_x(size_t d, size_t i, size_t n, double *v) const override
+    {
+        if (D_.isNull())
+            return 0;
+        DataStorePtr p = D_.lock();
+        std::vector<double> buff(n);
+        int m = p->get_x(dim_idx_[d], i, buff);
+        std::copy(buff.begin(), buff.begin() + m, v);
+        return m;
+    }
+
+private:
+    SqueezedDataStore();
 };
 
+// true if any of the data dims has size=1
+bool hasSingletonDim(const DataStorePtr d);
+
 Q_DECLARE_METATYPE(DataStorePtr)
 
 #endif // DATASLICE_H
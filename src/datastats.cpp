@@ -0,0 +1,600 @@
+#include "datastats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+// bin indexes beyond this are not representable, the width is increased
+const double max_bin_index = 4.0e18;
+
+int64_t floor_div2(int64_t k)
+{
+    return k >= 0 ? k / 2 : -((1 - k) / 2);
+}
+
+// fixed number of bins of width 2^e, starting at bin k0 = floor(x / 2^e)
+struct adaptive_histogram
+{
+    std::vector<size_t> counts;
+    int e{0};
+    double inv_w{1}; // 1 / 2^e
+    int64_t k0{0};
+    int64_t used_lo{1}, used_hi{0}; // occupied bins, empty if lo > hi
+
+    adaptive_histogram()
+        : counts(DataStats::maxBins)
+    {}
+
+    bool empty() const { return used_lo > used_hi; }
+    int64_t bin(double x) const { return int64_t(std::floor(x * inv_w)); }
+    bool representable(double x) const { return std::abs(x * inv_w) < max_bin_index; }
+
+    void coarsen()
+    {
+        std::vector<size_t> c(counts.size(), 0);
+        int64_t k1 = floor_div2(k0);
+        for (int64_t k = used_lo; k <= used_hi; ++k)
+            c[floor_div2(k) - k1] += counts[k - k0];
+        counts.swap(c);
+        k0 = k1;
+        if (!empty()) {
+            used_lo = floor_div2(used_lo);
+            used_hi = floor_div2(used_hi);
+        }
+        ++e;
+        inv_w = std::ldexp(1.0, -e);
+    }
+
+    // move the window so that it contains bins [lo, hi]
+    void shift(int64_t lo, int64_t hi)
+    {
+        const int64_t n = int64_t(counts.size());
+        if (lo >= k0 && hi < k0 + n)
+            return;
+        int64_t k1 = lo - (n - (hi - lo + 1)) / 2;
+        std::vector<size_t> c(counts.size(), 0);
+        for (int64_t k = used_lo; k <= used_hi; ++k)
+            c[k - k1] = counts[k - k0];
+        counts.swap(c);
+        k0 = k1;
+    }
+
+    // make room for the values in [lo, hi]
+    void include(double lo, double hi)
+    {
+        const int64_t n = int64_t(counts.size());
+        if (empty()) {
+            // initial width: the range spans about half of the bins
+            double span = hi - lo;
+            if (!(span > 0))
+                span = std::max(std::abs(lo) * 1e-6, std::numeric_limits<double>::min());
+            std::frexp(span / (n / 2), &e);
+            inv_w = std::ldexp(1.0, -e);
+        }
+        for (;;) {
+            if (representable(lo) && representable(hi)) {
+                int64_t a = bin(lo), b = bin(hi);
+                if (!empty()) {
+                    a = std::min(a, used_lo);
+                    b = std::max(b, used_hi);
+                }
+                if (b - a < n) {
+                    shift(a, b);
+                    return;
+                }
+            }
+            coarsen();
+        }
+    }
+
+    // add m values in [vmin, vmax]
+    void add(const double *v, size_t m, double vmin, double vmax, int64_t *idx)
+    {
+        include(vmin, vmax);
+        const int64_t a = bin(vmin), b = bin(vmax);
+        if (empty()) {
+            used_lo = a;
+            used_hi = b;
+        } else {
+            used_lo = std::min(used_lo, a);
+            used_hi = std::max(used_hi, b);
+        }
+
+        // bin index relative to vmin, computed without floor() so that
+        // the loop vectorizes; clamped to guard against round-off
+        const double f = inv_w;
+        const double x0 = double(a) / inv_w;
+        const int64_t imax = b - a;
+        for (size_t i = 0; i < m; ++i) {
+            int64_t j = int64_t((v[i] - x0) * f);
+            j = j < 0 ? 0 : j;
+            idx[i] = j > imax ? imax : j;
+        }
+        size_t *c = counts.data() + (a - k0);
+        for (size_t i = 0; i < m; ++i)
+            ++c[idx[i]];
+    }
+
+    void merge(adaptive_histogram &o)
+    {
+        if (o.empty())
+            return;
+        if (empty()) {
+            *this = o;
+            return;
+        }
+        while (e < o.e)
+            coarsen();
+        while (o.e < e)
+            o.coarsen();
+        while (std::max(used_hi, o.used_hi) - std::min(used_lo, o.used_lo) >= int64_t(counts.size())) {
+            coarsen();
+            o.coarsen();
+        }
+        int64_t lo = std::min(used_lo, o.used_lo), hi = std::max(used_hi, o.used_hi);
+        shift(lo, hi);
+        for (int64_t k = o.used_lo; k <= o.used_hi; ++k)
+            counts[k - k0] += o.counts[k - o.k0];
+        used_lo = lo;
+        used_hi = hi;
+    }
+};
+
+// partial result of one thread
+struct accumulator
+{
+    size_t count{0}, nan{0}, inf{0};
+    double min{std::numeric_limits<double>::infinity()};
+    double max{-std::numeric_limits<double>::infinity()};
+    double mean{0}, m2{0};
+    adaptive_histogram hist;
+
+    // Chan et al. merge of (count, mean, m2)
+    void merge(size_t nb, double meanb, double m2b)
+    {
+        if (nb == 0)
+            return;
+        size_t n = count + nb;
+        double delta = meanb - mean;
+        mean += delta * nb / n;
+        m2 += m2b + delta * delta * (double(count) * nb / n);
+        count = n;
+    }
+
+    void merge(accumulator &o)
+    {
+        merge(o.count, o.mean, o.m2);
+        nan += o.nan;
+        inf += o.inf;
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        hist.merge(o.hist);
+    }
+
+    // process one line of data, buff holds m values & is overwritten
+    void add(double *buff, size_t m, int64_t *idx)
+    {
+        // move the finite values to the front
+        size_t nf = 0;
+        for (size_t i = 0; i < m; ++i) {
+            double v = buff[i];
+            if (std::isfinite(v))
+                buff[nf++] = v;
+            else if (std::isnan(v))
+                ++nan;
+            else
+                ++inf;
+        }
+        if (nf == 0)
+            return;
+
+        double lmin = buff[0], lmax = buff[0], s = 0.;
+        for (size_t i = 0; i < nf; ++i) {
+            lmin = buff[i] < lmin ? buff[i] : lmin;
+            lmax = buff[i] > lmax ? buff[i] : lmax;
+            s += buff[i];
+        }
+        double lmean = s / nf, s2 = 0.;
+        for (size_t i = 0; i < nf; ++i) {
+            double d = buff[i] - lmean;
+            s2 += d * d;
+        }
+        merge(nf, lmean, s2);
+        min = std::min(min, lmin);
+        max = std::max(max, lmax);
+
+        hist.add(buff, nf, lmin, lmax, idx);
+    }
+};
+
+} // namespace
+
+double DataStats::std() const
+{
+    return std::sqrt(var);
+}
+
+std::vector<double> DataStats::histogram(size_t n, double lo, double hi) const
+{
+    std::vector<double> h(n, 0.);
+    if (n == 0 || !(hi > lo))
+        return h;
+    // split the count of each fine bin among the bins it overlaps
+    const double f = n / (hi - lo);
+    for (size_t j = 0; j < hist.size(); ++j) {
+        if (!hist[j])
+            continue;
+        double a = (hist_lo + j * hist_width - lo) * f;
+        double b = (hist_lo + (j + 1) * hist_width - lo) * f;
+        if (b <= 0. || a >= n)
+            continue;
+        double c = hist[j] / (b - a);
+        double x0 = std::max(a, 0.), x1 = std::min(b, double(n));
+        for (size_t k = size_t(x0); k < n && k < x1; ++k)
+            h[k] += c * (std::min(x1, k + 1.) - std::max(x0, double(k)));
+    }
+    return h;
+}
+
+double DataStats::quantile(double p) const
+{
+    if (count == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+    double target = p * count;
+    double acc = 0.;
+    for (size_t j = 0; j < hist.size(); ++j) {
+        if (acc + hist[j] >= target && hist[j]) {
+            double x = hist_lo + (j + (target - acc) / hist[j]) * hist_width;
+            return std::min(std::max(x, min), max);
+        }
+        acc += hist[j];
+    }
+    return max;
+}
+
+size_t DataStats::memory_usage() const
+{
+    return sizeof(*this) + memoryUsage(hist);
+}
+
+namespace {
+
+size_t nthreads_for(size_t size, size_t nparts)
+{
+    if (size < (1 << 16))
+        return 1;
+    return std::max(size_t(1), std::min(size_t(DataReduction::maxThreads()), nparts));
+}
+
+// run work(t) for t = 0 ... nthreads - 1, in parallel
+template<class F>
+void parallel(size_t nthreads, F work)
+{
+    if (nthreads == 1) {
+        work(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; ++t)
+        threads.emplace_back(work, t);
+    for (std::thread &th : threads)
+        th.join();
+}
+
+// merge the thread results into s
+void finalize(std::vector<accumulator> &acc, DataStats &s)
+{
+    for (size_t t = 1; t < acc.size(); ++t)
+        acc[0].merge(acc[t]);
+
+    accumulator &a = acc[0];
+    s.count = a.count;
+    s.nan = a.nan;
+    s.inf = a.inf;
+    if (a.count) {
+        s.min = a.min;
+        s.max = a.max;
+        s.mean = a.mean;
+        s.var = a.m2 / a.count;
+        s.hist_width = std::ldexp(1.0, a.hist.e);
+        s.hist_lo = a.hist.used_lo * s.hist_width;
+        s.hist.assign(a.hist.counts.begin() + (a.hist.used_lo - a.hist.k0),
+                      a.hist.counts.begin() + (a.hist.used_hi - a.hist.k0 + 1));
+    }
+}
+
+} // namespace
+
+bool DataStats::compute(const AbstractDataStore &d, DataStats &s, const std::atomic<bool> *cancel)
+{
+    s = DataStats();
+
+    // the dims at the start; the store is read holding its layout lock
+    // & the computation stops if it is resized meanwhile
+    const uint64_t layout = d.layout();
+    if (layout & 1)
+        return false;
+    AbstractDataStore::dim_t dim;
+    {
+        auto lock = d.lock_layout();
+        if (d.layout() != layout)
+            return false;
+        if (d.empty() || !d.is_numeric())
+            return true;
+        dim = d.dim();
+    }
+
+    // stream the data along its longest dim
+    const size_t dl = find_max(dim) - dim.begin();
+    const size_t n = dim[dl];
+    size_t size = 1;
+    for (size_t m : dim)
+        size *= m;
+    const size_t nlines = size / n;
+
+    std::atomic<bool> resized{false};
+    const size_t nthreads = nthreads_for(size, nlines);
+    std::vector<accumulator> acc(nthreads);
+    parallel(nthreads, [&](size_t t) {
+        accumulator &a = acc[t];
+        AbstractDataStore::vec_t buff(n);
+        std::vector<int64_t> idx(n);
+        AbstractDataStore::dim_t i0(dim.size(), 0);
+        size_t l0 = nlines * t / nthreads, l1 = nlines * (t + 1) / nthreads;
+        for (size_t l = l0; l < l1; ++l) {
+            if ((cancel && *cancel) || resized)
+                return;
+            // line index -> offset, last dim fastest
+            size_t k = l;
+            for (size_t j = dim.size(); j-- > 0;) {
+                if (j == dl)
+                    continue;
+                i0[j] = k % dim[j];
+                k /= dim[j];
+            }
+            size_t m;
+            {
+                auto lock = d.lock_layout();
+                if (d.layout() != layout) {
+                    resized = true;
+                    return;
+                }
+                d.read_consistent([&]() { m = d.get_y(dl, i0, buff); });
+            }
+            a.add(buff.data(), m, idx.data());
+        }
+    });
+    if ((cancel && *cancel) || resized)
+        return false;
+
+    finalize(acc, s);
+    return true;
+}
+
+bool DataStats::compute(const double *v, size_t n, DataStats &s, const std::atomic<bool> *cancel)
+{
+    s = DataStats();
+    if (n == 0)
+        return true;
+
+    // process in chunks that fit in cache
+    const size_t chunk = 1 << 14;
+    const size_t nchunks = (n + chunk - 1) / chunk;
+
+    const size_t nthreads = nthreads_for(n, nchunks);
+    std::vector<accumulator> acc(nthreads);
+    parallel(nthreads, [&](size_t t) {
+        accumulator &a = acc[t];
+        std::vector<double> buff(chunk);
+        std::vector<int64_t> idx(chunk);
+        size_t c0 = nchunks * t / nthreads, c1 = nchunks * (t + 1) / nthreads;
+        for (size_t c = c0; c < c1; ++c) {
+            if (cancel && *cancel)
+                return;
+            size_t i0 = c * chunk, m = std::min(chunk, n - i0);
+            std::copy(v + i0, v + i0 + m, buff.data());
+            a.add(buff.data(), m, idx.data());
+        }
+    });
+    if (cancel && *cancel)
+        return false;
+
+    finalize(acc, s);
+    return true;
+}
+
+/*************** DataStatsCache ******************/
+
+DataStatsCache::DataStatsCache(QObject *parent)
+    : QObject(parent)
+{
+    thread_ = std::thread(&DataStatsCache::run_, this);
+}
+
+DataStatsCache::~DataStatsCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        quit_ = true;
+        cancel_ = true;
+        queue_.clear();
+    }
+    cv_.notify_all();
+    thread_.join();
+    released_.clear();
+}
+
+const DataStatsCache::entry *DataStatsCache::find_(const AbstractDataStore *d) const
+{
+    auto it = cache_.find(d);
+    if (it == cache_.end() || it->second.D.isNull())
+        return nullptr;
+    return &(it->second);
+}
+
+void DataStatsCache::request(const DataStorePtr &d)
+{
+    if (!d || !d->is_numeric())
+        return;
+
+    entry &e = cache_[d.data()];
+    // a new entry, or the entry of a deleted store at the same address
+    if (e.D.isNull())
+        e = entry();
+    if (e.computing || (e.ready && !e.stale))
+        return;
+    e.D = d;
+    e.computing = true;
+    e.again = false;
+    e.gen = ++gen_;
+    e.version = d->version();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.push_back({d, e.gen});
+    }
+    cv_.notify_all();
+}
+
+void DataStatsCache::invalidate(const AbstractDataStore *d)
+{
+    prune_();
+    auto it = cache_.find(d);
+    if (it == cache_.end())
+        return;
+    entry &e = it->second;
+    const uint64_t v = e.version;
+    if (v && !(v & 1) && d->version() == v)
+        return;
+    // the running pass is completed, not restarted on every change
+    if (e.computing)
+        e.again = true;
+    else
+        e.stale = true;
+}
+
+const DataStats *DataStatsCache::stats(const AbstractDataStore *d) const
+{
+    const entry *e = find_(d);
+    return e && e->ready ? &(e->stats) : nullptr;
+}
+
+bool DataStatsCache::stale(const AbstractDataStore *d) const
+{
+    const entry *e = find_(d);
+    return e && e->stale;
+}
+
+bool DataStatsCache::pending(const AbstractDataStore *d) const
+{
+    const entry *e = find_(d);
+    return e && e->computing;
+}
+
+size_t DataStatsCache::memoryUsage() const
+{
+    size_t n = sizeof(*this);
+    for (const auto &i : cache_)
+        n += i.second.stats.memory_usage();
+    return n;
+}
+
+size_t DataStatsCache::cacheUsage() const
+{
+    size_t n{0};
+    for (const auto &i : cache_)
+        n += i.second.ready ? i.second.stats.memory_usage() : 0;
+    return n;
+}
+
+size_t DataStatsCache::releaseCaches()
+{
+    size_t n = cacheUsage();
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        entry &e = it->second;
+        if (e.ready && !e.computing) {
+            it = cache_.erase(it);
+            continue;
+        }
+        // the entry of a running pass is kept for its result
+        if (e.ready) {
+            e.stats = DataStats();
+            e.ready = false;
+        }
+        ++it;
+    }
+    return n - cacheUsage();
+}
+
+void DataStatsCache::run_()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+        cv_.wait(lock, [this]() { return quit_ || !queue_.empty(); });
+        if (quit_)
+            return;
+
+        job j = std::move(queue_.front());
+        queue_.pop_front();
+        cancel_ = false;
+        lock.unlock();
+
+        DataStats s;
+        bool ok = DataStats::compute(*j.D, s, &cancel_);
+
+        lock.lock();
+        // the job may hold the last reference to the store: it is moved
+        // out of this thread, to be released in the GUI thread
+        if (quit_) {
+            released_.push_back(std::move(j.D));
+            return;
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, D = std::move(j.D), gen = j.gen, ok, s]() { finished_(D, gen, ok, s); },
+            Qt::QueuedConnection);
+    }
+}
+
+void DataStatsCache::prune_()
+{
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (it->second.D.isNull())
+            it = cache_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void DataStatsCache::finished_(const DataStorePtr &d, unsigned gen, bool ok, const DataStats &s)
+{
+    // entries of deleted stores are dropped once per computation, not
+    // on every request
+    prune_();
+    auto it = cache_.find(d.data());
+    if (it == cache_.end() || it->second.gen != gen)
+        return;
+    entry &e = it->second;
+    const bool again = e.again;
+    e.computing = false;
+    e.again = false;
+    // stopped by a resize, the last stats are kept until the next pass
+    if (!ok) {
+        e.stale = true;
+        if (again)
+            request(d);
+        return;
+    }
+    e.stats = s;
+    e.ready = true;
+    e.stale = again;
+    touch();
+    // changed during the pass: one more, the stale stats are shown meanwhile
+    if (again)
+        request(d);
+    MemoryAccount::enforceBudget();
+    emit statsReady(d.data());
+}
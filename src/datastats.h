@@ -0,0 +1,138 @@
+#ifndef DATASTATS_H
+#define DATASTATS_H
+
+#include "dataslice.h"
+
+#include <QObject>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// Global statistics & value histogram of a numeric data store
+//
+// Computed in a single streaming pass over the data. Mean & variance are
+// accumulated per data line and merged with Chan's parallel update of
+// Welford's algorithm. The histogram has a fixed number of bins of width
+// 2^e; when a value falls outside, the width is doubled by merging
+// adjacent bins, so that the range is not needed in advance.
+struct DataStats
+{
+    size_t count{0}; // finite values
+    size_t nan{0};   // NaN values
+    size_t inf{0};   // +-infinite values
+    double min{0}, max{0}, mean{0}, var{0};
+
+    // fine histogram of the finite values
+    // bin j is [hist_lo + j * hist_width, hist_lo + (j + 1) * hist_width)
+    double hist_lo{0}, hist_width{0};
+    std::vector<size_t> hist;
+
+    double std() const;
+    double hist_hi() const { return hist_lo + hist.size() * hist_width; }
+
+    // rebin the fine histogram into n bins over [lo, hi]
+    // the count of a fine bin is split among the bins it overlaps
+    std::vector<double> histogram(size_t n, double lo, double hi) const;
+    // approximate value below which a fraction p of the values lie
+    double quantile(double p) const;
+
+    size_t memory_usage() const;
+
+    // max number of fine histogram bins
+    static const size_t maxBins = 4096;
+
+    // compute the stats of d using up to DataReduction::maxThreads()
+    // return false if canceled or d was resized meanwhile
+    static bool compute(const AbstractDataStore &d,
+                        DataStats &s,
+                        const std::atomic<bool> *cancel = nullptr);
+    // compute the stats of the n values in v
+    static bool compute(const double *v,
+                        size_t n,
+                        DataStats &s,
+                        const std::atomic<bool> *cancel = nullptr);
+};
+
+// Per data store cache of DataStats, computed in a background thread
+//
+// Stats are requested from the GUI thread and statsReady() is emitted
+// there when they become available. Entries refer to the store with a weak
+// pointer, so they become invalid when the store is deleted.
+//
+// A change of the store does not cancel a running pass: the last complete
+// stats are kept, marked stale, and a single new pass follows the running
+// one however many changes came meanwhile.
+class DataStatsCache : public QObject, public MemoryConsumer
+{
+    Q_OBJECT
+
+public:
+    explicit DataStatsCache(QObject *parent = nullptr);
+    ~DataStatsCache();
+
+    // queue the computation of the stats of d, unless they are up to date
+    // or being computed
+    void request(const DataStorePtr &d);
+    // d changed: its stats become stale, or are computed again once the
+    // running pass completes
+    // ignored if d tracks its version & it did not change since the request
+    void invalidate(const AbstractDataStore *d);
+    // the last complete stats of d, nullptr if not (yet) available
+    const DataStats *stats(const AbstractDataStore *d) const;
+    // true if d changed since its stats were computed
+    bool stale(const AbstractDataStore *d) const;
+    // true if the stats of d are queued or being computed
+    bool pending(const AbstractDataStore *d) const;
+
+    // memory accounting
+    size_t memoryUsage() const override;
+    size_t cacheUsage() const override;
+    size_t releaseCaches() override;
+
+signals:
+    void statsReady(const AbstractDataStore *d);
+
+private:
+    struct entry
+    {
+        QWeakPointer<AbstractDataStore> D;
+        DataStats stats;
+        bool ready{false};     // stats holds a complete pass
+        bool stale{false};     // d changed since that pass
+        bool computing{false}; // a pass is queued or running
+        bool again{false};     // d changed since it was queued
+        unsigned gen{0};
+        uint64_t version{0}; // of the store at the request
+    };
+    struct job
+    {
+        DataStorePtr D;
+        unsigned gen;
+    };
+
+    // GUI thread only
+    std::map<const AbstractDataStore *, entry> cache_;
+    unsigned gen_{0};
+
+    // shared with the worker thread
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<job> queue_;
+    std::atomic<bool> cancel_{false};
+    bool quit_{false};
+    std::thread thread_;
+    // stores of the jobs still running at quit, released after the join
+    std::vector<DataStorePtr> released_;
+
+    const entry *find_(const AbstractDataStore *d) const;
+    // drop the entries of deleted stores
+    void prune_();
+    void run_();
+    void finished_(const DataStorePtr &d, unsigned gen, bool ok, const DataStats &s);
+};
+
+#endif // DATASTATS_H
@@ -0,0 +1,336 @@
+#include "datatreemodel.h"
+
+#include <algorithm>
+
+DataTreeModel::DataTreeModel(QObject *parent)
+    : QAbstractItemModel(parent),
+      groupIcon_(":/qdatabrowser/icons/lucide/folder.svg"),
+      dataIcon_(":/qdatabrowser/icons/lucide/layers.svg")
+{
+    nodes_.resize(1);
+    nodes_[root].flags = Group;
+    strings_.push_back(QString());
+    refs_.push_back(0);
+    stringIds_.insert(QString(), 0);
+}
+
+unsigned DataTreeModel::intern_(const QString &s)
+{
+    if (s.isEmpty())
+        return 0;
+    auto it = stringIds_.constFind(s);
+    if (it != stringIds_.constEnd())
+    {
+        ++refs_[it.value()];
+        return it.value();
+    }
+    unsigned id;
+    if (freeStrings_.empty())
+    {
+        id = unsigned(strings_.size());
+        strings_.push_back(s);
+        refs_.push_back(1);
+    }
+    else
+    {
+        id = freeStrings_.back();
+        freeStrings_.pop_back();
+        strings_[id] = s;
+        refs_[id] = 1;
+    }
+    stringIds_.insert(s, id);
+    return id;
+}
+
+// drop a reference to a string, its id is reused when unreferenced
+void DataTreeModel::release_(unsigned id)
+{
+    if (id == 0 || --refs_[id])
+        return;
+    stringIds_.remove(strings_[id]);
+    strings_[id] = QString();
+    freeStrings_.push_back(id);
+}
+
+// the node is in the tree, i.e. no node up to the root is deferred
+bool DataTreeModel::inTree_(int id) const
+{
+    for (; id != root; id = nodes_[id].parent)
+        if (nodes_[id].flags & Pending)
+            return false;
+    return true;
+}
+
+int DataTreeModel::add(int parent, const QString &name, const QString &desc, bool group, bool defer)
+{
+    int id;
+    if (free_.empty())
+    {
+        id = int(nodes_.size());
+        nodes_.emplace_back();
+    }
+    else
+    {
+        id = free_.back();
+        free_.pop_back();
+    }
+    node &n = nodes_[id];
+    n.parent = parent;
+    n.name = intern_(name);
+    n.desc = intern_(desc);
+    n.flags = group ? Group : 0;
+    if (!byName_.contains(key_(parent, n.name)))
+        byName_.insert(key_(parent, n.name), id);
+
+    std::vector<int> &ch = nodes_[parent].children;
+    if (!inTree_(parent))
+    {
+        n.row = int(ch.size());
+        ch.push_back(id);
+    }
+    else if (defer)
+    {
+        n.flags |= Pending;
+        pending_[parent].push_back(id);
+    }
+    else
+    {
+        int row = int(ch.size());
+        beginInsertRows(indexOf(parent), row, row);
+        n.row = row;
+        ch.push_back(id);
+        endInsertRows();
+    }
+    return id;
+}
+
+void DataTreeModel::insertPending()
+{
+    for (auto it = pending_.begin(); it != pending_.end(); ++it)
+    {
+        std::vector<int> &ch = nodes_[it.key()].children;
+        const std::vector<int> &ids = it.value();
+        int row = int(ch.size());
+        beginInsertRows(indexOf(it.key()), row, row + int(ids.size()) - 1);
+        for (int id : ids)
+        {
+            nodes_[id].flags &= ~Pending;
+            nodes_[id].row = int(ch.size());
+            ch.push_back(id);
+        }
+        endInsertRows();
+    }
+    pending_.clear();
+}
+
+void DataTreeModel::remove(int id)
+{
+    if (id == root || (nodes_[id].flags & (Free | Pending)))
+        return;
+    const int parent = nodes_[id].parent;
+    const int row = nodes_[id].row;
+    const unsigned name = nodes_[id].name;
+
+    beginRemoveRows(indexOf(parent), row, row);
+    std::vector<int> &ch = nodes_[parent].children;
+    ch.erase(ch.begin() + row);
+    for (int r = row; r < int(ch.size()); ++r)
+        nodes_[ch[r]].row = r;
+    free_node_(id);
+    endRemoveRows();
+
+    // a sibling with the same name takes its place in the name index
+    if (!byName_.contains(key_(parent, name)))
+        for (int j : ch)
+            if (nodes_[j].name == name)
+            {
+                byName_.insert(key_(parent, name), j);
+                break;
+            }
+}
+
+// free a node & the nodes below it
+void DataTreeModel::free_node_(int id)
+{
+    node &n = nodes_[id];
+    for (int j : n.children)
+        free_node_(j);
+    auto it = byName_.find(key_(n.parent, n.name));
+    if (it != byName_.end() && it.value() == id)
+        byName_.erase(it);
+    release_(n.name);
+    release_(n.desc);
+    n = node();
+    n.flags = Free;
+    free_.push_back(id);
+}
+
+void DataTreeModel::clear()
+{
+    beginResetModel();
+    nodes_.resize(1);
+    nodes_[root].children.clear();
+    free_.clear();
+    strings_.resize(1);
+    refs_.resize(1);
+    freeStrings_.clear();
+    stringIds_.clear();
+    stringIds_.insert(QString(), 0);
+    byName_.clear();
+    pending_.clear();
+    endResetModel();
+}
+
+int DataTreeModel::find(int parent, const QString &name) const
+{
+    auto s = stringIds_.constFind(name);
+    if (s == stringIds_.constEnd())
+        return -1;
+    return byName_.value(key_(parent, s.value()), -1);
+}
+
+void DataTreeModel::setDescription(int id, const QString &desc)
+{
+    const unsigned old = nodes_[id].desc;
+    nodes_[id].desc = intern_(desc);
+    release_(old);
+    QModelIndex i = indexOf(id);
+    if (i.isValid())
+        emit dataChanged(i, i, {Qt::ToolTipRole});
+}
+
+QString DataTreeModel::path(int id) const
+{
+    if (id <= root)
+        return QString();
+    return QString("%1/%2").arg(path(nodes_[id].parent)).arg(name(id));
+}
+
+bool DataTreeModel::isStale(int id) const
+{
+    unsigned u = 0;
+    for (int i = id; i >= 0; i = nodes_[i].parent)
+        u = std::max(u, nodes_[i].updated);
+    return u > nodes_[id].refreshed;
+}
+
+bool DataTreeModel::isBelow(int id, int node) const
+{
+    for (int i = id; i >= 0; i = nodes_[i].parent)
+        if (i == node)
+            return true;
+    return false;
+}
+
+void DataTreeModel::setLazy(int id, bool on)
+{
+    if (on)
+        nodes_[id].flags |= Lazy;
+    else
+        nodes_[id].flags &= ~Lazy;
+}
+
+QModelIndex DataTreeModel::indexOf(int id) const
+{
+    if (id <= root || (nodes_[id].flags & (Free | Pending)))
+        return QModelIndex();
+    return createIndex(nodes_[id].row, 0, quintptr(id));
+}
+
+void DataTreeModel::setTitle(const QString &t)
+{
+    title_ = t;
+    emit headerDataChanged(Qt::Horizontal, 0, 0);
+}
+
+size_t DataTreeModel::memoryUsage() const
+{
+    size_t n = nodes_.capacity() * sizeof(node) + free_.capacity() * sizeof(int);
+    for (const node &i : nodes_)
+        n += i.children.capacity() * sizeof(int);
+    // QString data (with a header of ~3 pointers) & the hash of the pool
+    for (const QString &s : strings_)
+        n += sizeof(QString) + 3 * sizeof(void *) + s.size() * sizeof(QChar);
+    n += (refs_.capacity() + freeStrings_.capacity()) * sizeof(unsigned);
+    n += stringIds_.size() * (sizeof(QString) + sizeof(unsigned) + 2 * sizeof(void *));
+    n += byName_.size() * (sizeof(quint64) + sizeof(int) + 2 * sizeof(void *));
+    return n;
+}
+
+QModelIndex DataTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const std::vector<int> &ch = nodes_[node_(parent)].children;
+    if (column != 0 || row < 0 || row >= int(ch.size()))
+        return QModelIndex();
+    return createIndex(row, 0, quintptr(ch[row]));
+}
+
+QModelIndex DataTreeModel::parent(const QModelIndex &child) const
+{
+    return child.isValid() ? indexOf(nodes_[node_(child)].parent) : QModelIndex();
+}
+
+int DataTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return 0;
+    return int(nodes_[node_(parent)].children.size());
+}
+
+int DataTreeModel::columnCount(const QModelIndex &) const
+{
+    return 1;
+}
+
+QVariant DataTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    const node &n = nodes_[node_(index)];
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return strings_[n.name];
+    case Qt::DecorationRole:
+        return (n.flags & Group) ? groupIcon_ : dataIcon_;
+    case Qt::ToolTipRole:
+        if (n.desc)
+            return strings_[n.desc];
+        return (n.flags & Group) ? "Group" : "Data array";
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags DataTreeModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    // groups are not selectable
+    return isGroup(node_(index)) ? Qt::ItemIsEnabled : Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+QVariant DataTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (section == 0 && orientation == Qt::Horizontal && role == Qt::DisplayRole)
+        return title_;
+    return QVariant();
+}
+
+bool DataTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    int id = node_(parent);
+    return (nodes_[id].flags & Lazy) || !nodes_[id].children.empty();
+}
+
+bool DataTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    return nodes_[node_(parent)].flags & Lazy;
+}
+
+void DataTreeModel::fetchMore(const QModelIndex &parent)
+{
+    int id = node_(parent);
+    if ((nodes_[id].flags & Lazy) && fetch)
+        fetch(id);
+}
@@ -0,0 +1,133 @@
+#ifndef DATATREEMODEL_H
+#define DATATREEMODEL_H
+
+#include "dataslice.h"
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QIcon>
+
+#include <functional>
+#include <vector>
+
+// The model of the QDataBrowser data tree
+//
+// Nodes are kept in one vector and referred to by their id, the index in
+// the vector; id 0 is the root. A node holds its parent, its row in the
+// parent, its name & description as ids in a pool of unique strings, its
+// flags, the ids of its children & the data store. Strings are reference
+// counted & the ids of unused ones are reused. Model indexes carry
+// the node id, so index() & parent() are O(1). Children are also found
+// by name in one hash, keyed by parent & name id. All nodes share the
+// same 2 icons. Ids of removed nodes are reused.
+//
+// Rows may be deferred, to insert the children of a group at once with
+// insertPending(); children of a deferred node are added directly.
+class DataTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit DataTreeModel(QObject *parent = nullptr);
+
+    static const int root = 0;
+
+    // add a node below parent, return its id
+    // with defer the row is inserted by the next insertPending()
+    int add(int parent, const QString &name, const QString &desc, bool group, bool defer = false);
+    void insertPending();
+    // remove the row of a node & free the nodes below it
+    void remove(int id);
+    // remove all nodes but the root
+    void clear();
+
+    // the 1st child of parent with the given name, -1 if none
+    int find(int parent, const QString &name) const;
+
+    bool isGroup(int id) const { return nodes_[id].flags & Group; }
+    int parentOf(int id) const { return nodes_[id].parent; }
+    const std::vector<int> &children(int id) const { return nodes_[id].children; }
+    QString name(int id) const { return strings_[nodes_[id].name]; }
+    QString description(int id) const { return strings_[nodes_[id].desc]; }
+    void setDescription(int id, const QString &desc);
+    // /group/.../name
+    QString path(int id) const;
+
+    const DataStorePtr &store(int id) const { return nodes_[id].store; }
+    void setStore(int id, const DataStorePtr &D) { nodes_[id].store = D; }
+
+    // update epochs: of the last change posted at a node & of the last
+    // refresh of its data (views & stats)
+    void setUpdated(int id, unsigned epoch) { nodes_[id].updated = epoch; }
+    void setRefreshed(int id, unsigned epoch) { nodes_[id].refreshed = epoch; }
+    // a change was posted at or above the node after its last refresh, O(depth)
+    bool isStale(int id) const;
+    // id is node or below it, O(depth)
+    bool isBelow(int id, int node) const;
+
+    // lazy groups have children listed by fetch() on demand
+    bool isLazy(int id) const { return nodes_[id].flags & Lazy; }
+    void setLazy(int id, bool on);
+    std::function<void(int)> fetch;
+
+    // node id of a model index, -1 if invalid
+    int id(const QModelIndex &i) const { return i.isValid() ? int(i.internalId()) : -1; }
+    // model index of a node, invalid for the root & deferred nodes
+    QModelIndex indexOf(int id) const;
+
+    void setTitle(const QString &t);
+
+    size_t memoryUsage() const;
+
+    // QAbstractItemModel
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    enum Flags { Group = 1, Lazy = 2, Pending = 4, Free = 8 };
+
+    struct node
+    {
+        int parent{-1};
+        int row{0};
+        unsigned name{0}, desc{0}; // string ids
+        unsigned flags{0};
+        unsigned updated{0}, refreshed{0}; // epochs
+        std::vector<int> children;
+        DataStorePtr store;
+    };
+    std::vector<node> nodes_;
+    std::vector<int> free_;
+
+    // string pool, id 0 is the empty string
+    std::vector<QString> strings_;
+    std::vector<unsigned> refs_; // nodes referring to each string
+    std::vector<unsigned> freeStrings_;
+    QHash<QString, unsigned> stringIds_;
+
+    // children by (parent, name id)
+    QHash<quint64, int> byName_;
+
+    // deferred rows per parent
+    QHash<int, std::vector<int>> pending_;
+
+    QIcon groupIcon_, dataIcon_;
+    QString title_;
+
+    int node_(const QModelIndex &i) const { return i.isValid() ? int(i.internalId()) : root; }
+    unsigned intern_(const QString &s);
+    void release_(unsigned id);
+    bool inTree_(int id) const;
+    void free_node_(int id);
+    static quint64 key_(int parent, unsigned name) { return (quint64(unsigned(parent)) << 32) | name; }
+};
+
+#endif // DATATREEMODEL_H
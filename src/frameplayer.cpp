@@ -0,0 +1,131 @@
+#include "frameplayer.h"
+
+#include "datareduction.h"
+
+#include <QTimer>
+
+#include <algorithm>
+
+FramePlayer::FramePlayer(QObject *parent)
+    : QObject{parent}
+{
+    timer_ = new QTimer(this);
+    timer_->setTimerType(Qt::PreciseTimer);
+    connect(timer_, &QTimer::timeout, this, &FramePlayer::tick_);
+}
+
+FramePlayer::~FramePlayer()
+{
+    stop();
+}
+
+void FramePlayer::start(const fetch_t &fetch, const prepare_t &prepare)
+{
+    stop();
+    fetch_ = fetch;
+    prepare_ = prepare;
+    shown_ = dropped_ = 0;
+    last_ = 0;
+    queue_.clear();
+    busy_ = next_ = due_ = 0;
+    quit_ = false;
+
+    // frame 0 is due now
+    t0_ = 0.;
+    clock_.start();
+
+    size_t n = std::min(size_t(DataReduction::maxThreads()), queueDepth);
+    for (size_t i = 0; i < n; ++i)
+        threads_.emplace_back(&FramePlayer::run_, this);
+    timer_->start(std::max(int(1000. / fps_ / 2), 1));
+}
+
+void FramePlayer::stop()
+{
+    timer_->stop();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        quit_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread &th : threads_)
+        th.join();
+    threads_.clear();
+    queue_.clear();
+    // release what the functions hold, e.g. the data store
+    fetch_ = fetch_t();
+    prepare_ = prepare_t();
+}
+
+void FramePlayer::setFps(double fps)
+{
+    if (!(fps > 0.))
+        return;
+    if (playing())
+    {
+        // keep the current frame, change the rate from now on
+        t0_ = clock_.nsecsElapsed() * 1e-9 * fps_ + t0_;
+        clock_.start();
+        timer_->setInterval(std::max(int(1000. / fps / 2), 1));
+    }
+    fps_ = fps;
+}
+
+size_t FramePlayer::dueFrame_() const
+{
+    return size_t(t0_ + clock_.nsecsElapsed() * 1e-9 * fps_);
+}
+
+// GUI thread: show the latest frame that is due, never wait
+// the timer runs at twice the frame rate, so that a frame is shown
+// within half a period of becoming due
+void FramePlayer::tick_()
+{
+    size_t due = dueFrame_();
+    FramePtr f;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        due_ = due;
+        auto it = queue_.begin();
+        while (it != queue_.end() && it->first <= due)
+        {
+            f = it->second;
+            it = queue_.erase(it);
+        }
+    }
+    cv_.notify_all();
+
+    if (!f || (shown_ && f->t <= last_))
+        return;
+    dropped_ += shown_ ? f->t - last_ - 1 : f->t;
+    last_ = f->t;
+    ++shown_;
+    emit frameReady(f);
+}
+
+void FramePlayer::run_()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;)
+    {
+        cv_.wait(lock, [this]() { return quit_ || queue_.size() + busy_ < queueDepth; });
+        if (quit_)
+            return;
+
+        // never fetch frames that are already late
+        FramePtr f = std::make_shared<Frame>();
+        f->t = std::max(next_, due_);
+        next_ = f->t + 1;
+        ++busy_;
+
+        lock.unlock();
+        fetch_(*f);
+        if (prepare_)
+            prepare_(*f);
+        lock.lock();
+
+        // a late frame is still shown if nothing newer is ready
+        --busy_;
+        queue_[f->t] = f;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef FRAMEPLAYER_H
+#define FRAMEPLAYER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QTimer;
+
+// Playback of a sequence of frames at a target rate
+//
+// Worker threads fetch (and optionally prepare, e.g. color-map) upcoming
+// frames into a bounded queue, ahead of the frame that is due. A timer in
+// the GUI thread takes the latest frame that is due from the queue and
+// emits frameReady(); it never waits for a frame. Frames that are not
+// ready in time are dropped: the workers skip ahead to the due frame and
+// older queued frames are discarded.
+class FramePlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Frame
+    {
+        size_t t{0};                       // frame number since start
+        std::vector<size_t> i0;            // position of the frame
+        std::vector<double> y, dy;         // frame data
+        std::shared_ptr<void> prepared;    // set by the prepare function
+    };
+    typedef std::shared_ptr<Frame> FramePtr;
+
+    // fill frame t, called concurrently from the worker threads
+    typedef std::function<void(Frame &f)> fetch_t;
+    // further work on a fetched frame, in the worker threads
+    typedef std::function<void(Frame &f)> prepare_t;
+
+    explicit FramePlayer(QObject *parent = nullptr);
+    ~FramePlayer();
+
+    // max number of frames fetched ahead
+    static const size_t queueDepth = 8;
+
+    void start(const fetch_t &fetch, const prepare_t &prepare = prepare_t());
+    void stop();
+    bool playing() const { return !threads_.empty(); }
+
+    double fps() const { return fps_; }
+    void setFps(double fps);
+
+    // frames shown & dropped since start
+    size_t shown() const { return shown_; }
+    size_t dropped() const { return dropped_; }
+
+signals:
+    void frameReady(FramePlayer::FramePtr f);
+
+private:
+    double fps_{10.};
+    QTimer *timer_;
+    QElapsedTimer clock_;
+    double t0_{0.}; // frame number at the clock start, for fps changes
+    size_t shown_{0}, dropped_{0};
+    size_t last_{0};
+
+    fetch_t fetch_;
+    prepare_t prepare_;
+
+    // shared with the worker threads
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::map<size_t, FramePtr> queue_;
+    size_t busy_{0}; // frames being fetched
+    size_t next_{0}; // next frame to fetch
+    size_t due_{0};  // frame due on screen
+    bool quit_{false};
+    std::vector<std::thread> threads_;
+
+    size_t dueFrame_() const;
+    void tick_();
+    void run_();
+};
+
+Q_DECLARE_METATYPE(FramePlayer::FramePtr)
+
+#endif // FRAMEPLAYER_H
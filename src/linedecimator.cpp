@@ -0,0 +1,93 @@
+#include "linedecimator.h"
+
+#include <limits>
+
+LineDecimator::LineDecimator(size_t maxBuckets)
+    : maxb_(maxBuckets < 2 ? 2 : maxBuckets + maxBuckets % 2)
+{
+}
+
+void LineDecimator::clear()
+{
+    b_.clear();
+    width_ = 1;
+    n_ = 0;
+}
+
+void LineDecimator::append(const double *x, const double *y, size_t n)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i, ++n_) {
+        // start a new bucket
+        if (n_ % width_ == 0) {
+            if (b_.size() == maxb_)
+                merge_();
+            b_.push_back({x[i], inf, x[i], -inf, false});
+        }
+        bucket &b = b_.back();
+        if (y[i] < b.ylo) {
+            b.ylo = y[i];
+            b.xlo = x[i];
+        }
+        if (y[i] > b.yhi) {
+            b.yhi = y[i];
+            b.xhi = x[i];
+        }
+        b.nan = b.nan || y[i] != y[i];
+    }
+}
+
+// merge adjacent buckets, all full
+void LineDecimator::merge_()
+{
+    size_t m = b_.size() / 2;
+    for (size_t k = 0; k < m; ++k) {
+        const bucket &b0 = b_[2 * k], &b1 = b_[2 * k + 1];
+        bucket b = b0;
+        if (b1.ylo < b.ylo) {
+            b.ylo = b1.ylo;
+            b.xlo = b1.xlo;
+        }
+        if (b1.yhi > b.yhi) {
+            b.yhi = b1.yhi;
+            b.xhi = b1.xhi;
+        }
+        b.nan = b0.nan || b1.nan;
+        b_[k] = b;
+    }
+    b_.resize(m);
+    width_ *= 2;
+}
+
+void LineDecimator::line(std::vector<double> &x, std::vector<double> &y) const
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    x.clear();
+    y.clear();
+    x.reserve(2 * b_.size());
+    y.reserve(2 * b_.size());
+    for (const bucket &b : b_) {
+        if (b.ylo > b.yhi) { // only NaN
+            x.push_back(b.xlo);
+            y.push_back(nan);
+            continue;
+        }
+        // min & max in x order, once if the same point
+        bool lofirst = b.xlo <= b.xhi;
+        x.push_back(lofirst ? b.xlo : b.xhi);
+        y.push_back(lofirst ? b.ylo : b.yhi);
+        if (b.xlo != b.xhi) {
+            x.push_back(lofirst ? b.xhi : b.xlo);
+            y.push_back(lofirst ? b.yhi : b.ylo);
+        }
+        if (b.nan && width_ > 1) {
+            x.push_back(x.back());
+            y.push_back(nan);
+        }
+    }
+}
+
+size_t LineDecimator::memory_usage() const
+{
+    return sizeof(*this) + b_.capacity() * sizeof(bucket);
+}
@@ -0,0 +1,52 @@
+#ifndef LINEDECIMATOR_H
+#define LINEDECIMATOR_H
+
+#include <cstddef>
+#include <vector>
+
+// Min/max decimation of a long line for plotting
+//
+// Consecutive points are grouped in buckets of 2^k points, each keeping
+// its min & max y and their x. Drawing the min & max of every bucket in
+// order preserves the envelope of the line with at most 2 x maxBuckets()
+// points. Points are appended incrementally; when the buckets are full,
+// adjacent pairs are merged and the bucket width doubles, so the cost
+// is O(1) amortized per appended point.
+class LineDecimator
+{
+public:
+    static const size_t defaultBuckets = 4096;
+
+    // max number of buckets, rounded up to even
+    explicit LineDecimator(size_t maxBuckets = defaultBuckets);
+    size_t maxBuckets() const { return maxb_; }
+
+    void clear();
+    // append n points
+    void append(const double *x, const double *y, size_t n);
+    // number of points appended since the last clear
+    size_t size() const { return n_; }
+    // points per bucket
+    size_t width() const { return width_; }
+
+    // the decimated line, the points themselves when width() == 1
+    // NaN y values are kept, as line breaks
+    void line(std::vector<double> &x, std::vector<double> &y) const;
+
+    size_t memory_usage() const;
+
+private:
+    struct bucket
+    {
+        double xlo, ylo, xhi, yhi; // min & max y and their x
+        bool nan;                  // contains NaN values
+    };
+    std::vector<bucket> b_;
+    size_t maxb_;
+    size_t width_{1};
+    size_t n_{0};
+
+    void merge_();
+};
+
+#endif // LINEDECIMATOR_H
@@ -0,0 +1,129 @@
+#include "memoryaccount.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+std::recursive_mutex mtx_;
+std::vector<MemoryConsumer *> consumers_;
+std::atomic<size_t> budget_{0};
+std::atomic<unsigned long long> clock_{0};
+
+} // namespace
+
+MemoryConsumer::MemoryConsumer()
+    : lastUse_(MemoryAccount::tick())
+{
+    MemoryAccount::add(this);
+}
+
+MemoryConsumer::MemoryConsumer(const MemoryConsumer &other)
+    : lastUse_(MemoryAccount::tick())
+{
+    MemoryAccount::add(this);
+}
+
+MemoryConsumer::~MemoryConsumer()
+{
+    MemoryAccount::remove(this);
+}
+
+void MemoryConsumer::touch()
+{
+    lastUse_ = MemoryAccount::tick();
+}
+
+size_t MemoryAccount::usage()
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx_);
+    size_t n{0};
+    for (const MemoryConsumer *c : consumers_)
+        n += c->memoryUsage();
+    return n;
+}
+
+size_t MemoryAccount::cacheUsage()
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx_);
+    size_t n{0};
+    for (const MemoryConsumer *c : consumers_)
+        n += c->cacheUsage();
+    return n;
+}
+
+size_t MemoryAccount::budget()
+{
+    return budget_;
+}
+
+void MemoryAccount::setBudget(size_t bytes)
+{
+    budget_ = bytes;
+    enforceBudget();
+}
+
+size_t MemoryAccount::enforceBudget()
+{
+    size_t b = budget_;
+    if (b == 0)
+        return 0;
+
+    std::lock_guard<std::recursive_mutex> lock(mtx_);
+
+    size_t total{0};
+    for (const MemoryConsumer *c : consumers_)
+        total += c->memoryUsage();
+    if (total <= b)
+        return 0;
+
+    // least recently used first
+    std::vector<MemoryConsumer *> lru(consumers_);
+    std::sort(lru.begin(), lru.end(), [](const MemoryConsumer *a, const MemoryConsumer *b) {
+        return a->lastUse_ < b->lastUse_;
+    });
+
+    size_t freed{0};
+    for (MemoryConsumer *c : lru)
+    {
+        if (total <= b + freed)
+            break;
+        if (c->cacheUsage())
+            freed += c->releaseCaches();
+    }
+    return freed;
+}
+
+void MemoryAccount::add(MemoryConsumer *c)
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx_);
+    consumers_.push_back(c);
+}
+
+void MemoryAccount::remove(MemoryConsumer *c)
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx_);
+    auto it = std::find(consumers_.begin(), consumers_.end(), c);
+    if (it != consumers_.end())
+        consumers_.erase(it);
+}
+
+unsigned long long MemoryAccount::tick()
+{
+    return ++clock_;
+}
+
+size_t memoryUsage(const std::string &s)
+{
+    static const size_t sso = std::string().capacity();
+    return s.capacity() > sso ? s.capacity() + 1 : 0;
+}
+
+size_t memoryUsage(const std::vector<std::string> &v)
+{
+    size_t n = v.capacity() * sizeof(std::string);
+    for (const std::string &s : v)
+        n += memoryUsage(s);
+    return n;
+}
@@ -0,0 +1,76 @@
+#ifndef MEMORYACCOUNT_H
+#define MEMORYACCOUNT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// An object holding memory that is accounted for by MemoryAccount
+//
+// Objects register themselves on construction and unregister on destruction.
+// They report the bytes they hold in memoryUsage() and may release
+// memory that can be recomputed (caches) in releaseCaches().
+class MemoryConsumer
+{
+public:
+    MemoryConsumer();
+    MemoryConsumer(const MemoryConsumer &other);
+    virtual ~MemoryConsumer();
+
+    MemoryConsumer &operator=(const MemoryConsumer &) { return *this; }
+
+    // bytes currently held
+    virtual size_t memoryUsage() const = 0;
+    // bytes held by caches, included in memoryUsage()
+    virtual size_t cacheUsage() const { return 0; }
+    // release the caches, return the bytes freed
+    virtual size_t releaseCaches() { return 0; }
+
+    // mark as recently used; least recently used caches are released first
+    void touch();
+
+private:
+    unsigned long long lastUse_{0};
+
+    friend class MemoryAccount;
+};
+
+// Global memory accounting & budget
+class MemoryAccount
+{
+public:
+    // total bytes held by all registered consumers
+    static size_t usage();
+    // bytes held by caches of all registered consumers
+    static size_t cacheUsage();
+
+    // memory budget in bytes, 0 = unlimited
+    static size_t budget();
+    static void setBudget(size_t bytes);
+
+    // release caches, least recently used first,
+    // until usage is within budget
+    // return the bytes freed
+    static size_t enforceBudget();
+
+private:
+    static void add(MemoryConsumer *c);
+    static void remove(MemoryConsumer *c);
+    static unsigned long long tick();
+
+    friend class MemoryConsumer;
+};
+
+// approximate heap bytes held by a string, 0 if it fits in its own buffer
+size_t memoryUsage(const std::string &s);
+// approximate heap bytes held by a vector of strings
+size_t memoryUsage(const std::vector<std::string> &v);
+
+// approximate heap bytes held by a vector
+template<class T>
+size_t memoryUsage(const std::vector<T> &v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+#endif // MEMORYACCOUNT_H
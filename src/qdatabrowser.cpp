@@ -1,8 +1,11 @@
 #include "qdatabrowser.h"
 
 #include "dataslice.h"
+#include "datastats.h"
+#include "datatreemodel.h"
 #include "qdatasliceselector.h"
 #include "qdataview.h"
+#include "treesearchindex.h"
 
 #include <QClipboard>
 #include <QComboBox>
@@ -12,127 +15,70 @@
 #include <QHeaderView>
 #include <QItemSelectionModel>
 #include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QLocale>
 #include <QMenu>
 #include <QMessageBox>
+#include <QPainter>
 #include <QSplitter>
 #include <QStackedWidget>
-#include <QStandardItemModel>
 #include <QTableWidget>
 #include <QToolButton>
 #include <QTreeView>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
-bool hasSingletonDim(const DataStorePtr d)
+namespace {
+
+// registry of the views, with the built-in views in the order of ViewType
+std::vector<QDataBrowser::ViewInfo> builtinViews()
 {
-    if (d->empty())
-        return false;
-    for (size_t d : d->dim())
-    {
-        if (d == 1)
-            return true;
-    }
-    return false;
+    auto view = [](const char *name, const char *icon, int dims, int types, QDataBrowser::ViewCost cost,
+                   std::function<QAbstractDataView *()> create) {
+        QDataBrowser::ViewInfo v;
+        v.name = name;
+        v.icon = QIcon(icon);
+        v.dims = dims;
+        v.dataTypes = types;
+        v.cost = cost;
+        v.create = create;
+        return v;
+    };
+    std::vector<QDataBrowser::ViewInfo> r = {
+        view("Table", ":/qdatabrowser/icons/lucide/sheet.svg", 2, QDataBrowser::AnyData,
+             QDataBrowser::LightView, [] { return new QTabularDataView; }),
+        view("Line", ":/qdatabrowser/icons/lucide/chart-spline.svg", 1, QDataBrowser::NumericData,
+             QDataBrowser::HeavyView, [] { return new QPlotDataView; }),
+        view("HeatMap", ":/qdatabrowser/icons/lucide/map.svg", 2, QDataBrowser::NumericData,
+             QDataBrowser::HeavyView, [] { return new QHeatMapDataView; }),
+        view("Histogram", ":/qdatabrowser/icons/lucide/chart-column.svg", 2, QDataBrowser::NumericData,
+             QDataBrowser::HeavyView, [] { return new QHistogramDataView; }),
+        view("Traces", ":/qdatabrowser/icons/lucide/chart-line.svg", 2, QDataBrowser::NumericData,
+             QDataBrowser::HeavyView, [] { return new QTracesDataView; }),
+    };
+    for (size_t i = 0; i < r.size(); ++i)
+        r[i].id = int(i);
+    return r;
 }
 
-class SqueezedDataStore : public AbstractDataStore
+std::vector<QDataBrowser::ViewInfo> &viewRegistry()
 {
-public:
-    SqueezedDataStore(const DataStorePtr d)
-        : D_(d)
-    {
-        name_ = d->name();
-        desc_ = d->description();
-        if (!d->empty())
-        {
-            if (d->size() == 1)
-            { // scalar
-                dim_ = {1};
-                dim_name_ = {d->dim_name(0)};
-                dim_desc_ = {d->dim_desc(0)};
-                dim_idx_ = {0};
-            }
-            else
-            {
-                for (int i = 0; i < d->dim().size(); ++i)
-                {
-                    size_t n = d->dim()[i];
-                    if (n > 1)
-                    {
-                        dim_.push_back(n);
-                        dim_idx_.push_back(i);
-                        dim_name_.push_back(d->dim_name(i));
-                        dim_desc_.push_back(d->dim_desc(i));
-                    }
-                }
-            }
-        }
-    }
-    virtual ~SqueezedDataStore() {}
-
-    bool is_numeric() const override { return D_.isNull() ? true : D_.lock()->is_numeric(); }
-    bool hasErrors() const override { return D_.isNull() ? false : D_.lock()->hasErrors(); }
-    bool is_x_categorical(size_t d) const override
-    {
-        return D_.isNull() ? false : D_.lock()->is_x_categorical(dim_idx_[d]);
-    }
-    size_t get_y_text(size_t d, const dim_t &i0, strvec_t &y) const override
-    {
-        return D_.isNull() ? 0 : D_.lock()->get_y_text(dim_idx_[d], i1(i0), y);
-    }
-    size_t get_x_categorical(size_t d, strvec_t &x) const override
-    {
-        return D_.isNull() ? 0 : D_.lock()->get_x_categorical(dim_idx_[d], x);
-    }
+    static std::vector<QDataBrowser::ViewInfo> r = builtinViews();
+    return r;
+}
 
-protected:
-    QWeakPointer<AbstractDataStore> D_;
-    dim_t dim_idx_;
+int nextViewId = QDataBrowser::Traces + 1;
 
-    // expand a pointer to squeezed data (i0) to a pointer to original data (i1)
-    dim_t i1(const dim_t &i0) const
-    {
-        dim_t i1_(D_.lock()->ndim(), 0);
-        for (int i = 0; i < ndim(); ++i)
-            i1_[dim_idx_[i]] = i0[i];
-        return i1_;
-    }
-
-    size_t get_y(size_t d, const dim_t &i0, size_t n, double *v) const override
-    {
-        if (D_.isNull())
-            return 0;
-        DataStorePtr p = D_.lock();
-        std::vector<double> buff(n);
-        int m = p->get_y(dim_idx_[d], i1(i0), buff);
-        std::copy(buff.begin(), buff.begin() + m, v);
-        return m;
-    }
-    size_t get_dy(size_t d, const dim_t &i0, size_t n, double *v) const override
-    {
-        if (D_.isNull())
-            return 0;
-        DataStorePtr p = D_.lock();
-        std::vector<double> buff(n);
-        int m = p->get_dy(dim_idx_[d], i1(i0), buff);
-        std::copy(buff.begin(), buff.begin() + m, v);
-        return m;
-    }
-    size_t get_x(size_t d, size_t n, double *v) const override
-    {
-        if (D_.isNull())
-            return 0;
-        DataStorePtr p = D_.lock();
-        std::vector<double> buff(n);
-        int m = p->get_x(dim_idx_[d], buff);
-        std::copy(buff.begin(), buff.begin() + m, v);
-        return m;
-    }
+bool supports(const QDataBrowser::ViewInfo &v, const DataStorePtr &D)
+{
+    return v.dataTypes & (D->is_numeric() ? QDataBrowser::NumericData : QDataBrowser::TextData);
+}
 
-private:
-    SqueezedDataStore();
-};
+} // namespace
 
 // this must be outside any namespace
 inline void __initResource__()
@@ -146,12 +92,19 @@ void QDataBrowser::initResources()
 }
 
 QDataBrowser::QDataBrowser(QWidget *parent, bool ignoreSingletonDims)
-    : QSplitter{parent}, ignoreSingletonDims_(ignoreSingletonDims), lastLeftPanelPos(100)
+    : QSplitter{parent}, ignoreSingletonDims_(ignoreSingletonDims),
+      searchIndex_(new TreeSearchIndex), lastLeftPanelPos(100)
 {
     /* create data model */
-    dataModel = new QStandardItemModel(0, 1, this);
+    dataModel = new DataTreeModel(this);
+    dataModel->fetch = [this](int g) { fetchLazyGroup(g); };
+    searchIndex_->compacted = [this](const std::vector<TreeSearchIndex::id_t> &newId) { remapSearchIds(newId); };
     setTreeTitle("Data Tables");
 
+    /* global data statistics, computed in the background */
+    dataStats = new DataStatsCache(this);
+    connect(dataStats, &DataStatsCache::statsReady, this, &QDataBrowser::onStatsReady);
+
     /* create left-side tree widget */
     dataTree = new QTreeView;
     dataTree->setModel(dataModel);
@@ -170,7 +123,38 @@ QDataBrowser::QDataBrowser(QWidget *parent, bool ignoreSingletonDims)
 
     QSplitter *leftSplitter = new QSplitter(Qt::Vertical);
     leftSplitter->setChildrenCollapsible(false);
-    leftSplitter->addWidget(dataTree);
+    {
+        QWidget *w = new QWidget;
+        QVBoxLayout *vbox = new QVBoxLayout;
+        vbox->setContentsMargins(0, 0, 0, 0);
+        vbox->setSpacing(0);
+        w->setLayout(vbox);
+
+        filterEdit = new QLineEdit;
+        filterEdit->setPlaceholderText("Filter");
+        filterEdit->setToolTip("Find data by name, description or path (with a '/')");
+        filterEdit->setClearButtonEnabled(true);
+        connect(filterEdit, &QLineEdit::textChanged, this, &QDataBrowser::onFilterChanged);
+        vbox->addWidget(filterEdit);
+
+        // filter matches, shown instead of the tree
+        filterResults = new QListWidget;
+        filterResults->setUniformItemSizes(true);
+        connect(filterResults,
+                &QListWidget::currentItemChanged,
+                this,
+                &QDataBrowser::onFilterResultSelected);
+        connect(filterResults,
+                &QListWidget::itemActivated,
+                this,
+                &QDataBrowser::onFilterResultActivated);
+
+        treeStack = new QStackedWidget;
+        treeStack->addWidget(dataTree);
+        treeStack->addWidget(filterResults);
+        vbox->addWidget(treeStack);
+        leftSplitter->addWidget(w);
+    }
     {
         QWidget *w = new QWidget;
         QVBoxLayout *vbox = new QVBoxLayout;
@@ -276,103 +260,149 @@ QDataBrowser::QDataBrowser(QWidget *parent, bool ignoreSingletonDims)
         vbox->addWidget(tlbox);
     }
 
-    /* create dataView panel */
+    /* create dataView panel & bottom toolbox
+       with empty pages, filled by createView() */
     viewTab = new QTabWidget;
     // viewTab->setStyleSheet("background: white");
-    dataView[0] = new QTabularDataView;
-    viewTab->addTab(dataView[0], dataView[0]->icon(), "Table");
-    dataView[1] = new QPlotDataView;
-    viewTab->addTab(dataView[1], dataView[1]->icon(), "Line");
-    dataView[2] = new QHeatMapDataView;
-    viewTab->addTab(dataView[2], dataView[2]->icon(), "HeatMap");
-    vbox->addWidget(viewTab);
-
-    /* create bottom toolbox */
+    bottomPanel = new QStackedWidget;
+    auto page = []() {
+        QWidget *w = new QWidget;
+        QVBoxLayout *l = new QVBoxLayout;
+        l->setContentsMargins(0, 0, 0, 0);
+        w->setLayout(l);
+        return w;
+    };
+    for (const ViewInfo &v : viewRegistry())
     {
-        bottomPanel = new QStackedWidget;
-
-        for (int i = 0; i < nViews; ++i)
-        {
-            sliceSelector[i] = new QDataSliceSelector;
-            bottomPanel->addWidget(sliceSelector[i]);
-            dataView[i]->setData(sliceSelector[i]->slice());
-            connect(sliceSelector[i],
-                    &QDataSliceSelector::sliceChanged,
-                    dataView[i],
-                    &QAbstractDataView::updateView);
-            connect(sliceSelector[i],
-                    &QDataSliceSelector::sliceChanged,
-                    this,
-                    &QDataBrowser::onSliceChanged);
-            connect(dataView[i],
-                    &QAbstractDataView::viewUpdated,
-                    this,
-                    &QDataBrowser::onViewUpdated);
-        }
-
-        connect(viewTab, &QTabWidget::currentChanged, bottomPanel, &QStackedWidget::setCurrentIndex);
-        connect(viewTab, &QTabWidget::currentChanged, this, &QDataBrowser::onCurrentViewChanged);
-
-        bottomSplitter->addWidget(bottomPanel);
+        views_.push_back({v});
+        viewTab->addTab(page(), v.icon, v.name);
+        bottomPanel->addWidget(page());
     }
+    vbox->addWidget(viewTab);
+    connect(viewTab, &QTabWidget::currentChanged, bottomPanel, &QStackedWidget::setCurrentIndex);
+    connect(viewTab, &QTabWidget::currentChanged, this, &QDataBrowser::onCurrentViewChanged);
+    bottomSplitter->addWidget(bottomPanel);
+    onCurrentViewChanged(viewTab->currentIndex());
 
     addWidget(leftSplitter);
     addWidget(bottomSplitter);
     setCollapsible(1, false);
 }
 
+QDataBrowser::~QDataBrowser() = default;
+
 void QDataBrowser::setTreeTitle(const QString &t)
 {
     treeTitle_ = t;
-    dataModel->setHeaderData(0, Qt::Horizontal, treeTitle_);
+    dataModel->setTitle(treeTitle_);
 }
 
 bool QDataBrowser::addGroup(const QString &name, const QString &location, const QString &desc)
 {
-    QStandardItem *parent = fromPath(location);
-    if (!parent)
+    int parent = fromPath(location);
+    if (parent < 0)
         return false;
     if (!isGroup(parent))
         return false;
-    QStandardItem *g = new QStandardItem(QIcon(":/qdatabrowser/icons/lucide/folder.svg"), name);
-    g->setData(QVariant::fromValue(DataStorePtr{}));
-    g->setSelectable(false);
-    g->setEditable(false);
-    g->setToolTip(desc.isEmpty() ? "Group" : desc);
-    parent->appendRow(g);
+    appendChild(parent, name, desc, true);
     return true;
 }
 
 bool QDataBrowser::addData(AbstractDataStore *data, const QString &location)
 {
-    QStandardItem *parent = fromPath(location);
-    if (!parent)
+    int parent = fromPath(location);
+    if (parent < 0)
         return false;
     if (!isGroup(parent))
         return false;
 
     QString name(data->name().c_str());
-    QStandardItem *node = findChild(name, parent);
-    if (!node)
+    int node = findChild(name, parent);
+    if (node < 0)
+        node = appendChild(parent, name, QString(), false);
+    setItemData(node, data);
+    return true;
+}
+
+int QDataBrowser::addGroups(const QStringList &paths)
+{
+    int n = 0;
+    for (const QString &path : paths)
+        n += ensureGroup(path) >= 0;
+    insertPending();
+    return n;
+}
+
+int QDataBrowser::addData(const QList<QPair<QString, AbstractDataStore *>> &items)
+{
+    int n = 0;
+    for (const auto &item : items)
     {
-        node = new QStandardItem(QIcon(":/qdatabrowser/icons/lucide/layers.svg"), name);
-        parent->appendRow(node);
+        AbstractDataStore *data = item.second;
+        int parent = ensureGroup(item.first);
+        if (parent < 0)
+        {
+            delete data; // we own it
+            continue;
+        }
+        QString name(data->name().c_str());
+        int node = findChild(name, parent);
+        if (node < 0)
+            node = appendChild(parent, name, QString(), false, true);
+        setItemData(node, data);
+        ++n;
     }
+    insertPending();
+    return n;
+}
 
-    node->setData(QVariant::fromValue(DataStorePtr(data)));
-    node->setEditable(false);
-    node->setToolTip(data->description().empty() ? "Data array" : data->description().c_str());
+void QDataBrowser::setItemData(int node, AbstractDataStore *data)
+{
+    lazyData_.remove(node);
+    DataStorePtr D(data);
+    dataModel->setStore(node, D);
+    dataModel->setRefreshed(node, updateEpoch_);
+    if (!data->description().empty())
+    {
+        dataModel->setDescription(node, data->description().c_str());
+        searchIndex_->describe(searchIds_[node], dataModel->description(node));
+    }
 
-    return true;
+    dataStats->request(D);
+}
+
+// the group at path, creating the missing groups
+// nullptr if a node on the path is not a group
+int QDataBrowser::ensureGroup(const QString &path)
+{
+    int i = DataTreeModel::root;
+    for (const QString &s : path.split('/', Qt::SkipEmptyParts))
+    {
+        int j = findChild(s, i);
+        if (j < 0)
+            j = appendChild(i, s, QString(), true, true);
+        else if (!isGroup(j))
+            return -1;
+        i = j;
+    }
+    return i;
+}
+
+// insert the queued rows, one insertion per parent group
+void QDataBrowser::insertPending()
+{
+    dataTree->setUpdatesEnabled(false);
+    dataModel->insertPending();
+    dataTree->setUpdatesEnabled(true);
 }
 
 bool QDataBrowser::selectItem(const QString &path)
 {
-    QStandardItem *item = fromPath(path);
-    if (!item)
+    int node = fromPath(path);
+    if (node < 0)
         return false;
 
-    QModelIndex i = item->index();
+    QModelIndex i = dataModel->indexOf(node);
     if (!i.isValid())
         return false;
 
@@ -380,132 +410,392 @@ bool QDataBrowser::selectItem(const QString &path)
     return true;
 }
 
+QString QDataBrowser::filter() const
+{
+    return filterEdit->text();
+}
+
+void QDataBrowser::setFilter(const QString &text)
+{
+    filterEdit->setText(text);
+}
+
+size_t QDataBrowser::treeMemoryUsage() const
+{
+    return dataModel->memoryUsage() + searchIndex_->memory_usage()
+           + searchIds_.capacity() * sizeof(unsigned) + searchNodes_.capacity() * sizeof(int);
+}
+
 void QDataBrowser::dataUpdated(const QString &path)
 {
-    QStandardItem *item = fromPath(path);
-    if (!item)
+    int node = fromPath(path);
+    if (node < 0)
         return;
-    dataUpdated(item);
+    dataUpdated(node);
 }
 
 void QDataBrowser::clear(const QString &path)
 {
-    QStandardItem *item = fromPath(path);
+    int item = fromPath(path);
 
-    if (!item)
+    if (item < 0)
         return;
 
-    if (item == dataModel->invisibleRootItem())
+    if (item == DataTreeModel::root)
     {
-        dataModel->removeRows(0, dataModel->rowCount());
+        dataModel->clear();
+        lazyGroups_.clear();
+        lazyData_.clear();
+        searchIndex_->clear();
+        searchIds_.clear();
+        searchNodes_.clear();
+        onFilterChanged(filterEdit->text());
         // setTreeTitle(treeTitle_);
         onDataItemSelect(QModelIndex(), QModelIndex());
         return;
     }
 
-    QModelIndex I = item->index();
+    QModelIndex I = dataModel->indexOf(item);
     if (!I.isValid())
         return;
 
     QModelIndex C = dataTree->currentIndex();
     bool currentDeleted = isGroup(item) ? isBelow(C, I) : I == C;
 
-    dataModel->removeRow(I.row(), I.parent());
+    removeItem(item);
+    if (!filterEdit->text().isEmpty())
+        onFilterChanged(filterEdit->text());
 
     if (currentDeleted)
     {
-        for (int i = 0; i < nViews; ++i)
-        {
-            sliceSelector[i]->clear();
-            dataView[i]->updateView();
-        }
+        shownNode_ = -1;
+        for (int i = 0; i < int(views_.size()); ++i)
+            assignView(i);
     }
 }
 
 QDataBrowser::PlotType QDataBrowser::plotType() const
 {
-    return ((QPlotDataView *)dataView[1])->plotType();
+    int i = viewIndex(Plot);
+    QPlotDataView *v = i < 0 ? nullptr : qobject_cast<QPlotDataView *>(views_[i].view);
+    return v ? v->plotType() : plotType_;
 }
 
 QDataBrowser::ViewType QDataBrowser::activeView() const
 {
-    return QDataBrowser::ViewType(viewTab->currentIndex());
+    int i = viewTab->currentIndex();
+    return QDataBrowser::ViewType(i < 0 ? -1 : views_[i].info.id);
 }
 
 void QDataBrowser::setPlotType(PlotType t)
 {
-    ((QPlotDataView *)dataView[1])->setPlotType(t);
+    plotType_ = t;
+    int i = viewIndex(Plot);
+    if (QPlotDataView *v = i < 0 ? nullptr : qobject_cast<QPlotDataView *>(views_[i].view))
+        v->setPlotType(t);
 }
 
 void QDataBrowser::setActiveView(ViewType t)
 {
-    viewTab->setCurrentIndex(t);
+    int i = viewIndex(t);
+    if (i >= 0)
+        viewTab->setCurrentIndex(i);
+}
+
+size_t QDataBrowser::memoryUsage(QDataBrowser::ViewType v) const
+{
+    int i = viewIndex(v);
+    return i >= 0 && views_[i].selector ? views_[i].selector->memoryUsage() : 0;
+}
+
+int QDataBrowser::registerView(const ViewInfo &v)
+{
+    std::vector<ViewInfo> &r = viewRegistry();
+    if (!v.create || v.dims < 1 || v.dims > 2 || v.name.isEmpty())
+        return -1;
+    if (std::any_of(r.begin(), r.end(), [&v](const ViewInfo &i) { return i.name == v.name; }))
+        return -1;
+    r.push_back(v);
+    r.back().id = nextViewId++;
+    return r.back().id;
+}
+
+bool QDataBrowser::unregisterView(const QString &name)
+{
+    std::vector<ViewInfo> &r = viewRegistry();
+    auto it = std::find_if(r.begin(), r.end(), [&name](const ViewInfo &i) { return i.name == name; });
+    if (it == r.end())
+        return false;
+    r.erase(it);
+    return true;
+}
+
+QList<QDataBrowser::ViewInfo> QDataBrowser::registeredViews()
+{
+    QList<ViewInfo> l;
+    for (const ViewInfo &v : viewRegistry())
+        l.append(v);
+    return l;
 }
 
-QStandardItem *QDataBrowser::fromPath(const QString &path) const
+int QDataBrowser::viewIndex(int id) const
+{
+    for (int i = 0; i < int(views_.size()); ++i)
+        if (views_[i].info.id == id)
+            return i;
+    return -1;
+}
+
+size_t QDataBrowser::totalMemoryUsage()
+{
+    return MemoryAccount::usage();
+}
+
+size_t QDataBrowser::memoryBudget()
+{
+    return MemoryAccount::budget();
+}
+
+void QDataBrowser::setMemoryBudget(size_t bytes)
+{
+    MemoryAccount::setBudget(bytes);
+}
+
+int QDataBrowser::fromPath(const QString &path)
 {
     if (path == "/" || path == "")
-        return dataModel->invisibleRootItem();
+        return DataTreeModel::root;
 
     QStringList lst = path.split('/');
     if (path.startsWith('/'))
         lst.takeFirst();
-    QStandardItem *i = dataModel->invisibleRootItem();
+    int i = DataTreeModel::root;
     for (const QString &s : lst)
     {
-        QStandardItem *j = findChild(s, i);
-        if (j == nullptr)
-            return nullptr;
+        int j = findChild(s, i);
+        if (j < 0)
+            return -1;
         else
             i = j;
     }
     return i;
 }
 
-QStandardItem *QDataBrowser::findChild(const QString &name, QStandardItem *parent) const
+int QDataBrowser::findChild(const QString &name, int parent)
+{
+    if (dataModel->isLazy(parent))
+        fetchLazyGroup(parent);
+    return dataModel->find(parent, name);
+}
+
+// add a node below parent & to the search index
+int QDataBrowser::appendChild(int parent, const QString &name, const QString &desc, bool group, bool defer)
+{
+    int node = dataModel->add(parent, name, desc, group, defer);
+    TreeSearchIndex::id_t id = searchIndex_->add(parent == DataTreeModel::root ? TreeSearchIndex::npos
+                                                                              : searchIds_[parent],
+                                                 name,
+                                                 desc);
+    searchIds_.resize(std::max(searchIds_.size(), size_t(node) + 1));
+    searchIds_[node] = id;
+    searchNodes_.resize(id + 1, -1);
+    searchNodes_[id] = node;
+    return node;
+}
+
+// remove a node, keeping the indexes in sync
+void QDataBrowser::removeItem(int node)
+{
+    dropIndex(node);
+    dataModel->remove(node);
+}
+
+// drop the index entries of a node and of the nodes below it
+void QDataBrowser::dropIndex(int node)
 {
-    for (int row = 0; row < parent->rowCount(); ++row)
+    // the removal may renumber the search ids
+    searchNodes_[searchIds_[node]] = -1;
+    searchIndex_->remove(searchIds_[node]);
+    lazyGroups_.remove(node);
+    lazyData_.remove(node);
+    for (int j : dataModel->children(node))
+        dropIndex(j);
+}
+
+// the search index dropped its removed nodes & renumbered the others
+void QDataBrowser::remapSearchIds(const std::vector<uint32_t> &newId)
+{
+    std::vector<int> nodes(searchIndex_->size(), -1);
+    for (size_t id = 0; id < newId.size() && id < searchNodes_.size(); ++id)
     {
-        QStandardItem *ch = parent->child(row);
-        QString s = ch->text();
-        if (s == name)
-            return ch;
+        int node = searchNodes_[id];
+        if (newId[id] == TreeSearchIndex::npos || node < 0)
+            continue;
+        nodes[newId[id]] = node;
+        searchIds_[node] = newId[id];
+    }
+    searchNodes_.swap(nodes);
+    searchNodes_.shrink_to_fit();
+
+    // the results of the filter refer to the old ids
+    for (int k = 0; k < filterResults->count(); ++k)
+    {
+        QListWidgetItem *r = filterResults->item(k);
+        QVariant id = r->data(Qt::UserRole);
+        if (!id.isValid())
+            continue;
+        if (id.toUInt() < newId.size() && newId[id.toUInt()] != TreeSearchIndex::npos)
+            r->setData(Qt::UserRole, newId[id.toUInt()]);
+        else
+            r->setData(Qt::UserRole, QVariant());
     }
-    return nullptr;
 }
 
-bool QDataBrowser::isGroup(QStandardItem *i)
+// the tree node of a filter result, nullptr if it was removed
+int QDataBrowser::filterItem(const QListWidgetItem *r) const
 {
-    if (i == nullptr)
-        return false;
-    return i == dataModel->invisibleRootItem() || i->data().value<DataStorePtr>().isNull();
+    QVariant id = r ? r->data(Qt::UserRole) : QVariant();
+    if (!id.isValid() || id.toUInt() >= searchNodes_.size())
+        return -1;
+    return searchNodes_[id.toUInt()];
 }
 
-QString QDataBrowser::itemPath(QStandardItem *i)
+bool QDataBrowser::addLazyGroup(const QString &name,
+                                const GroupProvider &children,
+                                const QString &location,
+                                const QString &desc)
 {
-    if (i == nullptr || i == dataModel->invisibleRootItem())
-        return QString();
-    return QString("%1/%2").arg(itemPath(i->parent())).arg(i->text());
+    int parent = fromPath(location);
+    if (parent < 0 || !isGroup(parent))
+        return false;
+    int g = appendChild(parent, name, desc, true);
+    if (children)
+    {
+        lazyGroups_.insert(g, children);
+        dataModel->setLazy(g, true);
+    }
+    return true;
 }
 
-bool QDataBrowser::dataUpdated(QStandardItem *i)
+// list the children of a lazy group & insert them at once
+void QDataBrowser::fetchLazyGroup(int g)
 {
-    if (isGroup(i))
+    GroupProvider provider = lazyGroups_.take(g);
+    dataModel->setLazy(g, false);
+    if (!provider)
+        return;
+    for (const LazyNode &n : provider())
     {
-        for (int r = 0; r < i->rowCount(); ++r)
+        int node = appendChild(g, n.name, n.description, n.isGroup(), true);
+        if (!n.isGroup())
+            lazyData_.insert(node, n.open);
+        else if (n.children)
         {
-            if (dataUpdated(i->child(r)))
-                return true;
+            lazyGroups_.insert(node, n.children);
+            dataModel->setLazy(node, true);
         }
+    }
+    insertPending();
+}
+
+// create the store of a lazy data node
+void QDataBrowser::openLazyData(int node)
+{
+    auto open = lazyData_.take(node);
+    AbstractDataStore *data = open ? open() : nullptr;
+    if (data)
+        setItemData(node, data);
+}
+
+bool QDataBrowser::isGroup(int node) const
+{
+    return node >= 0 && dataModel->isGroup(node);
+}
+
+QString QDataBrowser::itemPath(int node) const
+{
+    return node < 0 ? QString() : dataModel->path(node);
+}
+
+// stamp node with a new update epoch, the selected data is refreshed if
+// it is at or below node; other data are checked against the stamps of
+// their path when selected
+// [from, to) is the changed range of the last dim of the data at node
+bool QDataBrowser::dataUpdated(int node, size_t from, size_t to)
+{
+    dataModel->setUpdated(node, ++updateEpoch_);
+
+    int c = currentNode();
+    if (c < 0 || isGroup(c) || !dataModel->isBelow(c, node))
+        return false;
+    DataStorePtr D = dataModel->store(c);
+    if (!D)
         return false;
+
+    // a range applies to the data at node itself; a singleton last dim is
+    // squeezed out of the slice store, otherwise it is its last dim too
+    const bool range = c == node && (from > 0 || to < D->dim().back()) && D->dim().back() > 1;
+
+    // a running pass completes, then one more is run for all the updates
+    // since; the last stats are shown as stale meanwhile
+    dataStats->invalidate(D.data());
+    dataModel->setRefreshed(c, updateEpoch_);
+    const int current = viewTab->currentIndex();
+    for (int i = 0; i < int(views_.size()); ++i)
+    {
+        viewSlot &v = views_[i];
+        if (!v.selector || v.pending == viewSlot::Assign)
+            continue;
+        // hidden heavy views are refreshed when shown
+        if (i != current && v.info.cost == HeavyView)
+        {
+            v.pending = viewSlot::Update;
+            continue;
+        }
+        DataStorePtr S = v.selector->slice()->dataStore();
+        if (range && S)
+            v.selector->updateData(S->ndim() - 1, from, to);
+        else
+            v.selector->updateData();
+    }
+    dataStats->request(D);
+    updateStatsInfo();
+    return true;
+}
+
+void QDataBrowser::postUpdate(const QString &path)
+{
+    postUpdate(path, 0, SIZE_MAX);
+}
+
+void QDataBrowser::postUpdate(const QString &path, size_t from, size_t to)
+{
+    std::lock_guard<std::mutex> lock(postMtx_);
+    for (postedUpdate &u : posted_)
+        if (u.path == path)
+        {
+            u.from = std::min(u.from, from);
+            u.to = std::max(u.to, to);
+            return;
+        }
+    posted_.push_back({path, from, to});
+    if (posted_.size() == 1)
+        QMetaObject::invokeMethod(this, [this]() { onPostedUpdates(); }, Qt::QueuedConnection);
+}
+
+void QDataBrowser::onPostedUpdates()
+{
+    std::vector<postedUpdate> updates;
+    {
+        std::lock_guard<std::mutex> lock(postMtx_);
+        updates.swap(posted_);
     }
-    else if (i->index() == dataTree->currentIndex())
+    for (const postedUpdate &u : updates)
     {
-        for (int i = 0; i < nViews; ++i)
-            sliceSelector[i]->updateData();
-        return true;
+        int node = fromPath(u.path);
+        if (node >= 0)
+            dataUpdated(node, u.from, u.to);
     }
-    return false;
 }
 
 bool QDataBrowser::isBelow(const QModelIndex &i, const QModelIndex &g)
@@ -520,14 +810,21 @@ bool QDataBrowser::isBelow(const QModelIndex &i, const QModelIndex &g)
     return false;
 }
 
-void QDataBrowser::updateInfoTable(QStandardItem *it)
+// the selected node, -1 if none
+int QDataBrowser::currentNode() const
 {
-    DataStorePtr D = it->data().value<DataStorePtr>();
+    return dataModel->id(dataTree->currentIndex());
+}
+
+void QDataBrowser::updateInfoTable(int node)
+{
+    DataStorePtr D = dataModel->store(node);
     if (!D)
         return;
 
+    const int nStatsRows = D->is_numeric() ? 6 : 0;
     infoTable->setColumnCount(2);
-    infoTable->setRowCount(4 + D->ndim());
+    infoTable->setRowCount(4 + D->ndim() + nStatsRows);
 
     // infoTable->horizontalHeader()->hide();
     infoTable->verticalHeader()->hide();
@@ -591,12 +888,144 @@ void QDataBrowser::updateInfoTable(QStandardItem *it)
         infoTable->setItem(r, 1, item);
     }
 
+    statsInfoRow_ = nStatsRows ? r + 1 : 0;
+    memInfoRow_ = r + 1 + nStatsRows;
+    updateStatsInfo();
+
     // infoTable->resizeColumnToContents(0);
     infoTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     infoTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
     infoTable->horizontalHeader()->hide();
 }
 
+void QDataBrowser::updateStatsInfo()
+{
+    int node = currentNode();
+    DataStorePtr D = node < 0 ? DataStorePtr() : dataModel->store(node);
+    const DataStats *S = D ? dataStats->stats(D.data()) : nullptr;
+
+    for (const viewSlot &v : views_)
+        if (v.view)
+            v.view->setDatasetStats(S);
+
+    if (statsInfoRow_ == 0 || !D)
+        return;
+
+    QStringList names;
+    names << "Min" << "Max" << "Mean" << "Std" << "NaN / Inf" << "Histogram";
+    QStringList values;
+    QPixmap pix;
+    QString histTip;
+    const bool stale = S && dataStats->stale(D.data());
+
+    if (S)
+    {
+        values << QString::number(S->min) << QString::number(S->max) << QString::number(S->mean)
+               << QString::number(S->std())
+               << QString("%1 / %2").arg(S->nan).arg(S->inf);
+
+        // small bar chart of the value distribution
+        const int nbins = 64, h = 20;
+        std::vector<double> hist = S->histogram(nbins, S->min, S->max);
+        double hmax = *std::max_element(hist.begin(), hist.end());
+        pix = QPixmap(nbins * 2, h);
+        pix.fill(Qt::transparent);
+        QPainter p(&pix);
+        for (int k = 0; hmax > 0 && k < nbins; ++k)
+        {
+            int bh = int(std::ceil(double(h) * hist[k] / hmax));
+            p.fillRect(2 * k, h - bh, 2, bh, palette().color(QPalette::Highlight));
+        }
+        values << QString();
+        histTip = QString("%1 values in [%2, %3]").arg(S->count).arg(S->min).arg(S->max);
+    }
+    else
+    {
+        for (int k = 0; k < names.size(); ++k)
+            values << (dataStats->pending(D.data()) ? "computing ..." : "n/a");
+    }
+
+    for (int k = 0; k < names.size(); ++k)
+    {
+        QTableWidgetItem *item = new QTableWidgetItem(names[k]);
+        infoTable->setItem(statsInfoRow_ + k, 0, item);
+        item = new QTableWidgetItem(values[k]);
+        if (stale)
+        {
+            item->setForeground(palette().brush(QPalette::Disabled, QPalette::Text));
+            item->setToolTip("Computed before the last update, updating ...");
+        }
+        if (k == names.size() - 1 && !pix.isNull())
+        {
+            item->setData(Qt::DecorationRole, pix);
+            item->setToolTip(stale ? histTip + "\n" + item->toolTip() : histTip);
+        }
+        infoTable->setItem(statsInfoRow_ + k, 1, item);
+    }
+}
+
+void QDataBrowser::updateMemoryInfo()
+{
+    if (memInfoRow_ == 0)
+        return;
+
+    int node = currentNode();
+    DataStorePtr D = node < 0 ? DataStorePtr() : dataModel->store(node);
+    if (!D)
+        return;
+
+    QLocale loc;
+    auto fmt = [&loc](size_t n) { return loc.formattedDataSize(qint64(n)); };
+
+    QStringList names, values, tips;
+    names << "Store memory";
+    values << (D->memory_usage() ? fmt(D->memory_usage()) : QString("unknown"));
+    tips << QString();
+
+    for (const viewSlot &v : views_)
+    {
+        if (!v.selector)
+            continue;
+        DataSlice::buffer_usage_t u = v.selector->slice()->buffer_usage();
+        names << QString("%1 view memory").arg(v.info.name);
+        values << fmt(v.selector->memoryUsage());
+        tips << QString("data: %1\nerrors: %2\naxes: %3\ntext: %4\ncategories: %5\nlabels: %6")
+                    .arg(fmt(u.data))
+                    .arg(fmt(u.errors))
+                    .arg(fmt(u.axes))
+                    .arg(fmt(u.text))
+                    .arg(fmt(u.categories))
+                    .arg(fmt(v.selector->labelUsage()));
+    }
+
+    DataStorePtr P = dataProxy.value<DataStorePtr>();
+    if (P)
+    {
+        names << "Proxy memory";
+        values << fmt(P->memory_usage());
+        tips << "Squeezed data proxy";
+    }
+
+    names << "Data tree memory";
+    values << fmt(treeMemoryUsage());
+    tips << "Tree nodes & search index";
+
+    names << "Total memory";
+    values << (memoryBudget() ? QString("%1 of %2").arg(fmt(totalMemoryUsage())).arg(fmt(memoryBudget()))
+                              : fmt(totalMemoryUsage()));
+    tips << QString("All browsers, caches: %1").arg(fmt(MemoryAccount::cacheUsage()));
+
+    infoTable->setRowCount(memInfoRow_ + names.size());
+    for (int k = 0; k < names.size(); ++k)
+    {
+        QTableWidgetItem *item = new QTableWidgetItem(names[k]);
+        infoTable->setItem(memInfoRow_ + k, 0, item);
+        item = new QTableWidgetItem(values[k]);
+        item->setToolTip(tips[k]);
+        infoTable->setItem(memInfoRow_ + k, 1, item);
+    }
+}
+
 void QDataBrowser::onLeftSplitterMoved(int pos, int index)
 {
     int leftSize = sizes().front();
@@ -673,19 +1102,29 @@ void QDataBrowser::onBottomPanelBtClicked(bool c)
 
 void QDataBrowser::onDataItemSelect(const QModelIndex &selected, const QModelIndex &deselected)
 {
-    const int dim0[nViews] = {2, 1, 2};
-    QStandardItem *i = selected.isValid() ? dataModel->itemFromIndex(selected) : nullptr;
-    for (int v = 0; v < nViews; ++v)
-    {
-        sliceSelector[v]->clear();
-        dataView[v]->updateView();
-    }
+    int node = dataModel->id(selected);
+    if (lazyData_.contains(node))
+        openLazyData(node);
+    shownNode_ = -1;
+    // each view gets the selection once: the current one below, the
+    // others when shown
+    for (viewSlot &v : views_)
+        if (v.selector)
+            v.pending = viewSlot::Assign;
     infoTable->clear();
-    if (i)
+    statsInfoRow_ = 0;
+    memInfoRow_ = 0;
+    dataProxy.clear();
+    if (node >= 0)
     {
-        updateInfoTable(i);
         // get the data
-        DataStorePtr D = i->data().value<DataStorePtr>();
+        DataStorePtr D = dataModel->store(node);
+        // changes posted at or above it since it was last shown
+        if (D && dataModel->isStale(node))
+            dataStats->invalidate(D.data());
+        dataModel->setRefreshed(node, updateEpoch_);
+        dataStats->request(D);
+        updateInfoTable(node);
         // handle singleton dims option
         if (D && ignoreSingletonDims_ && hasSingletonDim(D))
         {
@@ -696,31 +1135,99 @@ void QDataBrowser::onDataItemSelect(const QModelIndex &selected, const QModelInd
         }
         if (D)
         {
-            if (D->is_numeric())
-            {
-                for (int i = 0; i < nViews; ++i)
-                {
-                    sliceSelector[i]->assign(D, dim0[i]);
-                    dataView[i]->updateView();
-                }
-            }
-            else
-            {
-                sliceSelector[0]->assign(D, dim0[0]);
-                dataView[0]->updateView();
-                setActiveView(QDataBrowser::Table);
-            }
+            shownNode_ = node;
+            // switch to the first view that supports the data
+            int c = viewTab->currentIndex();
+            if (c >= 0 && !supports(views_[c].info, D))
+                for (int i = 0; i < int(views_.size()); ++i)
+                    if (supports(views_[i].info, D))
+                    {
+                        viewTab->setCurrentIndex(i);
+                        break;
+                    }
         }
-        dataName->setText(itemPath(i));
+        assignCurrentView();
+        updateMemoryInfo();
+        dataName->setText(itemPath(node));
         copyPathBt->show();
     }
     else
     {
+        assignCurrentView();
+        updateStatsInfo();
         dataName->setText(QString());
         copyPathBt->hide();
     }
 }
 
+// assign the current view if it has not got the shown data yet
+void QDataBrowser::assignCurrentView()
+{
+    int c = viewTab->currentIndex();
+    if (c >= 0 && views_[c].pending == viewSlot::Assign)
+        assignView(c);
+}
+
+// create the view of tab i & its slice selector, if not yet done,
+// and show the selected data in it
+void QDataBrowser::createView(int i)
+{
+    if (i < 0 || views_[i].view)
+        return;
+    QAbstractDataView *v = views_[i].info.create();
+    // the tab stays empty
+    if (!v)
+        return;
+    QDataSliceSelector *s = new QDataSliceSelector;
+    views_[i].view = v;
+    views_[i].selector = s;
+    viewTab->widget(i)->layout()->addWidget(v);
+    bottomPanel->widget(i)->layout()->addWidget(s);
+
+    v->setData(s->slice());
+    connect(s, &QDataSliceSelector::sliceChanged, v, &QAbstractDataView::updateView);
+    connect(s, &QDataSliceSelector::sliceChanged, this, &QDataBrowser::onSliceChanged);
+    connect(v, &QAbstractDataView::viewUpdated, this, &QDataBrowser::onViewUpdated);
+    // playback frames go to the view, prepared by it
+    connect(s, &QDataSliceSelector::frameChanged, v, &QAbstractDataView::showFrame);
+    s->setFramePreparer([v]() { return v->framePreparer(); });
+    if (views_[i].info.id == Plot)
+        if (QPlotDataView *p = qobject_cast<QPlotDataView *>(v))
+            p->setPlotType(plotType_);
+
+    assignView(i);
+    updateStatsInfo();
+    updateMemoryInfo();
+}
+
+// show the data of shownNode_ in view i, if it is created & supports
+// their type; a hidden heavy view gets them when shown
+void QDataBrowser::assignView(int i)
+{
+    viewSlot &v = views_[i];
+    if (!v.selector)
+        return;
+    v.selector->clear();
+    v.pending = viewSlot::Current;
+    DataStorePtr D;
+    if (shownNode_ >= 0)
+    {
+        D = dataProxy.value<DataStorePtr>();
+        if (!D)
+            D = dataModel->store(shownNode_);
+    }
+    if (D && !supports(v.info, D))
+        D.reset();
+    if (D && v.info.cost == HeavyView && i != viewTab->currentIndex())
+    {
+        v.pending = viewSlot::Assign;
+        D.reset();
+    }
+    if (D)
+        v.selector->assign(D, v.info.dims);
+    v.view->updateView();
+}
+
 void QDataBrowser::onCopyPath()
 {
     QClipboard *clipboard = QGuiApplication::clipboard();
@@ -732,16 +1239,14 @@ void QDataBrowser::onSliceReset() {}
 
 void QDataBrowser::onSliceChanged()
 {
-    int i = viewTab->currentIndex();
-    bool ret = !sliceSelector[i]->slice()->empty();
-    actExportCSV->setEnabled(ret);
-    actExportImg->setEnabled(ret && dataView[i]->canExportImage());
+    onViewUpdated();
+    updateMemoryInfo();
 }
 
 void QDataBrowser::onExportCSV()
 {
     int i = viewTab->currentIndex();
-    if (sliceSelector[i]->slice()->empty())
+    if (i < 0 || !views_[i].selector || views_[i].selector->slice()->empty())
         return;
 
     QString fname = QFileDialog::getSaveFileName(this,
@@ -762,29 +1267,112 @@ void QDataBrowser::onExportCSV()
         return;
     }
 
-    sliceSelector[i]->slice()->export_csv(of);
+    views_[i].selector->slice()->export_csv(of);
 }
 
 void QDataBrowser::onExportPlot()
 {
     int i = viewTab->currentIndex();
-    if (!dataView[i]->canExportImage())
+    if (i < 0 || !views_[i].view || !views_[i].view->canExportImage())
         return;
-    dataView[i]->exportImage();
+    views_[i].view->exportImage();
 }
 
 void QDataBrowser::onCurrentViewChanged(int i)
 {
-    bool ret = !sliceSelector[i]->slice()->empty();
-    actExportCSV->setEnabled(ret);
-    actExportImg->setEnabled(ret && dataView[i]->canExportImage());
-    optionsBt->setMenu(dataView[i]->optionsMenu());
+    if (i < 0)
+        return;
+    createView(i);
+    // catch up with what the view missed while hidden
+    viewSlot &v = views_[i];
+    if (v.pending == viewSlot::Assign)
+        assignView(i);
+    else if (v.pending == viewSlot::Update)
+    {
+        v.pending = viewSlot::Current;
+        v.selector->updateData();
+    }
+    // only the visible view plays
+    for (int k = 0; k < int(views_.size()); ++k)
+        if (k != i && views_[k].selector)
+            views_[k].selector->stopPlayback();
+
+    onViewUpdated();
+    optionsBt->setMenu(v.view ? v.view->optionsMenu() : nullptr);
 }
 
 void QDataBrowser::onViewUpdated()
 {
     int i = viewTab->currentIndex();
-    bool ret = !sliceSelector[i]->slice()->empty();
+    if (i < 0 || !views_[i].selector)
+        return;
+    bool ret = !views_[i].selector->slice()->empty();
     actExportCSV->setEnabled(ret);
-    actExportImg->setEnabled(ret && dataView[i]->canExportImage());
+    actExportImg->setEnabled(ret && views_[i].view->canExportImage());
+}
+
+void QDataBrowser::onStatsReady(const AbstractDataStore *d)
+{
+    int node = currentNode();
+    DataStorePtr D = node < 0 ? DataStorePtr() : dataModel->store(node);
+    if (D.data() == d)
+    {
+        updateStatsInfo();
+        updateMemoryInfo();
+    }
+}
+
+void QDataBrowser::onFilterChanged(const QString &text)
+{
+    filterResults->clear();
+    if (text.isEmpty())
+    {
+        treeStack->setCurrentWidget(dataTree);
+        return;
+    }
+
+    std::vector<TreeSearchIndex::id_t> ids;
+    bool all = searchIndex_->find(text, maxFilterResults, ids);
+    filterResults->setUpdatesEnabled(false);
+    for (TreeSearchIndex::id_t id : ids)
+    {
+        QModelIndex i = dataModel->indexOf(searchNodes_[id]);
+        QListWidgetItem *r = new QListWidgetItem(i.data(Qt::DecorationRole).value<QIcon>(),
+                                                 itemPath(searchNodes_[id]));
+        r->setToolTip(i.data(Qt::ToolTipRole).toString());
+        r->setData(Qt::UserRole, id);
+        filterResults->addItem(r);
+    }
+    if (!all)
+    {
+        QListWidgetItem *r = new QListWidgetItem(
+            QString("More than %1 matches, refine the filter").arg(maxFilterResults));
+        r->setFlags(Qt::NoItemFlags);
+        filterResults->addItem(r);
+    }
+    filterResults->setUpdatesEnabled(true);
+    treeStack->setCurrentWidget(filterResults);
+}
+
+// show the data of the current result
+void QDataBrowser::onFilterResultSelected(QListWidgetItem *current)
+{
+    int node = filterItem(current);
+    if (node >= 0 && !isGroup(node))
+        dataTree->setCurrentIndex(dataModel->indexOf(node));
+}
+
+// go to the result in the tree
+void QDataBrowser::onFilterResultActivated(QListWidgetItem *r)
+{
+    int node = filterItem(r);
+    filterEdit->clear();
+    if (node < 0)
+        return;
+    QModelIndex idx = dataModel->indexOf(node);
+    dataTree->scrollTo(idx);
+    if (isGroup(node))
+        dataTree->expand(idx);
+    else
+        dataTree->setCurrentIndex(idx);
 }
@@ -1,16 +1,28 @@
 #ifndef QDATABROWSER_H
 #define QDATABROWSER_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <QHash>
+#include <QIcon>
 #include <QModelIndex>
 #include <QSplitter>
+#include <QStringList>
 
-class QStandardItemModel;
-class QStandardItem;
 class QTreeView;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
 class QToolButton;
 class QLabel;
 class QStackedWidget;
@@ -19,6 +31,9 @@ class QTableWidget;
 
 class QAbstractDataView;
 class QDataSliceSelector;
+class DataStatsCache;
+class DataTreeModel;
+class TreeSearchIndex;
 
 class AbstractDataStore;
 
@@ -42,7 +57,24 @@ public:
     {
         Table,
         Plot,
-        HeatMap
+        HeatMap,
+        Histogram,
+        Traces
+    };
+
+    // data a view can show, flags
+    enum DataType
+    {
+        NumericData = 1,
+        TextData = 2,
+        AnyData = NumericData | TextData
+    };
+    // cost of keeping a view up to date: light views follow the data
+    // while their tab is hidden, heavy views only when it is shown
+    enum ViewCost
+    {
+        LightView,
+        HeavyView
     };
 
     Q_ENUM(PlotType)
@@ -50,6 +82,7 @@ public:
 
 public:
     explicit QDataBrowser(QWidget *parent = nullptr, bool ignoreSingletonDims = true);
+    ~QDataBrowser();
 
     // init static lib resources (icons, etc.)
     static void initResources();
@@ -73,19 +106,106 @@ public:
     // will be deleted when not needed
     bool addData(AbstractDataStore *data, const QString &location = "/");
 
+    // Batch insertion of many nodes, e.g. when loading a file index
+    // Groups missing along the paths are created and the new rows are
+    // inserted in one step per existing parent group.
+    // Return the number of groups / data nodes inserted or updated
+    int addGroups(const QStringList &paths);
+    // pairs of (location, data), QDataBrowser takes ownership of the data
+    int addData(const QList<QPair<QString, AbstractDataStore *>> &items);
+
+    // Lazily populated trees, e.g. for the catalog of a large archive
+    // A lazy group lists its children through a callback only when it is
+    // first expanded or a path through it is looked up. Its data nodes
+    // create their store only when first selected.
+    struct LazyNode
+    {
+        QString name;
+        QString description;
+        // groups: list the children, nullptr for a plain (empty) group
+        std::function<QList<LazyNode>()> children;
+        // data nodes: create the store, QDataBrowser takes ownership
+        std::function<AbstractDataStore *()> open;
+        bool isGroup() const { return !open; }
+    };
+    typedef std::function<QList<LazyNode>()> GroupProvider;
+    bool addLazyGroup(const QString &name,
+                      const GroupProvider &children,
+                      const QString &location = "/",
+                      const QString &desc = QString());
+
     // select an item in the data tree
     bool selectItem(const QString &path);
 
+    // filter of the data tree, as in the box above it
+    // the nodes whose name or description contains the text (or the path,
+    // if the text has a '/') are listed instead of the tree
+    // children of lazy groups are found only once they are listed
+    QString filter() const;
+    void setFilter(const QString &text);
+
+    // bytes held by the data tree & its search index
+    size_t treeMemoryUsage() const;
+
     // call to signify that data at & below the give path have changed
-    // views are updated
+    // views are updated if they show data at or below path, other data
+    // are refreshed when next selected; GUI thread only
     void dataUpdated(const QString &path = "/");
+    // thread-safe dataUpdated, run in the GUI thread
+    // posts of the same path are merged until it runs
+    void postUpdate(const QString &path = "/");
+    // only the values at indexes [from, to) of the last dim of the data
+    // at path changed in place, e.g. frames written by an acquisition
+    // thread (see AbstractDataStore); views re-read only these values
+    void postUpdate(const QString &path, size_t from, size_t to);
 
     // remove the data node at path and its child nodes
     void clear(const QString &path = "/");
 
     QDataBrowser::PlotType plotType() const;
+    // ViewType or the id of a registered view, -1 if the browser has no views
     QDataBrowser::ViewType activeView() const;
 
+    // bytes held by the data slice & controls of a view, 0 if not created
+    size_t memoryUsage(QDataBrowser::ViewType v) const;
+
+    // Views
+    // The view tabs of a browser are taken, in order, from a registry
+    // shared by the application when the browser is created. The built-in
+    // views are registered with the id of their ViewType; other views get
+    // higher ids. A view is created when its tab is first shown and gets
+    // the selected data if it supports its type; hidden heavy views are
+    // refreshed when shown. Unregister the views an application does not
+    // use to leave them out of its browsers. GUI thread only.
+    struct ViewInfo
+    {
+        QString name;
+        QIcon icon;
+        // dims of the data slice, 1 or 2
+        int dims{2};
+        // DataType flags
+        int dataTypes{NumericData};
+        ViewCost cost{HeavyView};
+        // create the view, the browser takes ownership; a null view leaves
+        // its tab empty
+        std::function<QAbstractDataView *()> create;
+        // set by registerView()
+        int id{-1};
+    };
+    // add a view, return its id
+    // -1 if it has no create function, dims is not 1 or 2, or its name is
+    // empty or already registered (unregister that view to replace it)
+    static int registerView(const ViewInfo &v);
+    static bool unregisterView(const QString &name);
+    static QList<ViewInfo> registeredViews();
+
+    // global memory accounting, for all browsers in the application
+    // When the budget (in bytes, 0 = unlimited) is exceeded
+    // caches are released, least recently used first
+    static size_t totalMemoryUsage();
+    static size_t memoryBudget();
+    static void setMemoryBudget(size_t bytes);
+
 public slots:
     void setPlotType(QDataBrowser::PlotType t);
     void setActiveView(QDataBrowser::ViewType t);
@@ -98,16 +218,52 @@ private:
     bool ignoreSingletonDims_{true};
     QVariant dataProxy;
 
-    // data tree model
-    QStandardItemModel *dataModel;
+    // data tree model, nodes are referred to by id
+    DataTreeModel *dataModel;
     QString treeTitle_;
+    // lazy groups not yet expanded & data nodes not yet opened
+    QHash<int, GroupProvider> lazyGroups_;
+    QHash<int, std::function<AbstractDataStore *()>> lazyData_;
+    // search index of the tree nodes,
+    // the search id of each node & the node of each search id
+    std::unique_ptr<TreeSearchIndex> searchIndex_;
+    std::vector<unsigned> searchIds_;
+    std::vector<int> searchNodes_;
+    // epoch of the last dataUpdated
+    unsigned updateEpoch_{0};
+    // updates posted by postUpdate, a range of the last dim per path
+    struct postedUpdate
+    {
+        QString path;
+        size_t from, to;
+    };
+    std::mutex postMtx_;
+    std::vector<postedUpdate> posted_;
 
-    // view widgets
-    static const int nViews = 3;
-    QDataSliceSelector *sliceSelector[nViews];
-    QAbstractDataView *dataView[nViews];
+    // the views of the tabs, a view & its slice selector are created when
+    // its tab is first shown; tabs & bottom panel pages are containers
+    // until then
+    struct viewSlot
+    {
+        ViewInfo info;
+        QDataSliceSelector *selector{nullptr};
+        QAbstractDataView *view{nullptr};
+        // what a hidden heavy view missed: data updates or a new selection
+        enum { Current, Update, Assign } pending{Current};
+    };
+    std::vector<viewSlot> views_;
+    PlotType plotType_{Line};
+    // node of the data shown in the views, -1 if none
+    int shownNode_{-1};
     QTreeView *dataTree;
     QTableWidget *infoTable;
+    QLineEdit *filterEdit;
+    QListWidget *filterResults;
+    QStackedWidget *treeStack;
+    static const int maxFilterResults = 1000;
+
+    // global statistics of the data stores
+    DataStatsCache *dataStats;
 
     // layout widgets
     QTabWidget *viewTab;
@@ -127,13 +283,37 @@ private:
     QAction *actExportCSV;
     QAction *actExportImg;
 
-    QStandardItem *fromPath(const QString &path) const;
-    QStandardItem *findChild(const QString &name, QStandardItem *parent) const;
-    bool isGroup(QStandardItem *i);
-    QString itemPath(QStandardItem *i);
-    bool dataUpdated(QStandardItem *i);
+    // node ids, -1 if not found
+    int fromPath(const QString &path);
+    int findChild(const QString &name, int parent);
+    // add a node; batch insertion defers the rows until insertPending()
+    int appendChild(int parent, const QString &name, const QString &desc, bool group, bool defer = false);
+    void insertPending();
+    int ensureGroup(const QString &path);
+    void setItemData(int node, AbstractDataStore *data);
+    void removeItem(int node);
+    void dropIndex(int node);
+    // the index renumbered its ids (TreeSearchIndex::id_t)
+    void remapSearchIds(const std::vector<uint32_t> &newId);
+    int filterItem(const QListWidgetItem *r) const;
+    void fetchLazyGroup(int g);
+    void openLazyData(int node);
+    bool isGroup(int node) const;
+    QString itemPath(int node) const;
+    bool dataUpdated(int node, size_t from = 0, size_t to = SIZE_MAX);
+    // tab of a view id, -1 if none
+    int viewIndex(int id) const;
+    void createView(int i);
+    void assignView(int i);
+    void assignCurrentView();
+    void onPostedUpdates();
     bool isBelow(const QModelIndex &i, const QModelIndex &g);
-    void updateInfoTable(QStandardItem *i);
+    int currentNode() const;
+    void updateInfoTable(int node);
+    int statsInfoRow_{0};
+    void updateStatsInfo();
+    int memInfoRow_{0};
+    void updateMemoryInfo();
 
 private slots:
     void onLeftSplitterMoved(int pos, int index);
@@ -148,17 +328,60 @@ private slots:
     void onExportPlot();
     void onCurrentViewChanged(int i);
     void onViewUpdated();
+    void onStatsReady(const AbstractDataStore *d);
+    void onFilterChanged(const QString &text);
+    void onFilterResultSelected(QListWidgetItem *current);
+    void onFilterResultActivated(QListWidgetItem *r);
 };
 
+// Concurrency
+//
+// get_y() & co. may be called concurrently from the GUI thread & worker
+// threads (statistics, playback) and must not modify the store.
+//
+// A producer thread may change values in place, bracketing the writes with
+// begin_write() / end_write() (one writer at a time) and then calling
+// QDataBrowser::postUpdate(). The version is odd during a write and changes
+// with every write, so a reader detects a read that overlapped a write and
+// retries it (read_consistent(), a seqlock): neither side takes a lock.
+//
+// Changes of the dims or reallocation of the storage are allowed only in
+// the GUI thread, bracketed by begin_resize() / end_resize() and followed
+// by QDataBrowser::dataUpdated(). Worker threads read the store holding
+// lock_layout() and stop when layout() changed since they started, so
+// begin_resize() waits only for the reads in progress.
+//
+// Versions
+//
+// A store that reports every change, with begin_write() / end_write() or
+// with changed() in the GUI thread, has a version > 0 that increases with
+// each change; call changed() once when the store is ready to opt in.
+// Slices & statistics of such a store are not read again on an update
+// with an unchanged version. Version 0 means that changes are not tracked
+// and every update reads the data.
 class AbstractDataStore
 {
 public:
     typedef std::vector<size_t> dim_t;
     typedef std::vector<double> vec_t;
     typedef std::vector<std::string> strvec_t;
+    typedef std::shared_ptr<const strvec_t> categories_t;
 
     AbstractDataStore() = default;
-    AbstractDataStore(const AbstractDataStore &other) = default;
+    AbstractDataStore(const AbstractDataStore &other)
+        : dim_(other.dim_), name_(other.name_), desc_(other.desc_), dim_name_(other.dim_name_),
+          dim_desc_(other.dim_desc_)
+    {
+    }
+    AbstractDataStore &operator=(const AbstractDataStore &other)
+    {
+        dim_ = other.dim_;
+        name_ = other.name_;
+        desc_ = other.desc_;
+        dim_name_ = other.dim_name_;
+        dim_desc_ = other.dim_desc_;
+        return *this;
+    }
     AbstractDataStore(const std::string &n, const dim_t &d)
         : dim_(d), name_(n), dim_name_(d.size()), dim_desc_(d.size())
     {
@@ -190,9 +413,15 @@ public:
     const std::string &dim_name(size_t d) const { return dim_name_[d]; }
     const std::string &dim_desc(size_t d) const { return dim_desc_[d]; }
 
+    // approximate bytes held in memory by the data store, 0 if unknown
+    virtual size_t memory_usage() const { return 0; }
+
     virtual bool is_numeric() const { return true; }
     virtual bool hasErrors() const { return false; }
     virtual bool is_x_categorical(size_t d) const { return false; }
+    // values along dim d are only ever appended, existing ones never
+    // change: a slice along d then reads only the new values on update
+    virtual bool is_append_only(size_t d) const { return false; }
 
     size_t get_y(size_t d, const dim_t &i0, vec_t &y) const
     {
@@ -206,7 +435,70 @@ public:
         return get_dy(d, i0, y.size(), y.data());
     }
     size_t get_x(size_t d, vec_t &x) const { return get_x(d, x.size(), x.data()); }
+    // x values [i, i + x.size()) of dim d
+    size_t get_x(size_t d, size_t i, vec_t &x) const { return get_x(d, i, x.size(), x.data()); }
     virtual size_t get_x_categorical(size_t d, strvec_t &x) const { return 0; }
+    // the categories of dim d, nullptr if it is not categorical
+    // fetched with get_x_categorical() & shared by slices, selectors & views
+    // cached until a resize, a call to categories_changed() or a change of
+    // the size of d; value changes & the version do not refetch them
+    virtual categories_t categories(size_t d) const;
+    // the categories changed without a resize, GUI thread only
+    void categories_changed() { categories_gen_.fetch_add(1, std::memory_order_release); }
+
+    // in-place writes of a producer thread
+    void begin_write() { seq_.fetch_add(1, std::memory_order_acq_rel); }
+    void end_write() { seq_.fetch_add(1, std::memory_order_release); }
+    // any other change, GUI thread only
+    void changed() { seq_.fetch_add(2, std::memory_order_release); }
+    // odd while a write is in progress, 0 if changes are not tracked
+    virtual uint64_t version() const { return seq_.load(std::memory_order_acquire); }
+
+    // changes of the dims or reallocation of the storage, GUI thread only
+    // the version of a store that tracks its changes is increased too
+    void begin_resize()
+    {
+        layout_.fetch_add(1, std::memory_order_acq_rel);
+        layout_mtx_.lock();
+    }
+    void end_resize()
+    {
+        if (seq_.load(std::memory_order_relaxed))
+            changed();
+        categories_changed();
+        layout_.fetch_add(1, std::memory_order_release);
+        layout_mtx_.unlock();
+    }
+    // odd from the start of a resize until it ends, changes with each one
+    virtual uint64_t layout() const { return layout_.load(std::memory_order_acquire); }
+    // held by worker threads while reading, a resize waits for it
+    virtual std::shared_lock<std::shared_mutex> lock_layout() const
+    {
+        return std::shared_lock<std::shared_mutex>(layout_mtx_);
+    }
+
+    // run f, which reads the store, until it did not overlap a write
+    // return false if it still did after maxRetries; the values may then be
+    // torn, the producer's postUpdate() will have them read again
+    template<class F>
+    bool read_consistent(F f, int maxRetries = 8) const
+    {
+        for (int k = 0; k < maxRetries; ++k)
+        {
+            const uint64_t v = version();
+            if (v & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            f();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version() == v)
+                return true;
+        }
+        f();
+        return false;
+    }
 
 protected:
     dim_t dim_;
@@ -214,10 +506,27 @@ protected:
     std::string desc_;
     std::vector<std::string> dim_name_;
     std::vector<std::string> dim_desc_;
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<uint64_t> layout_{0};
+    mutable std::shared_mutex layout_mtx_;
+
+    std::atomic<uint64_t> categories_gen_{0};
+
+    struct category_cache_t
+    {
+        categories_t x;
+        uint64_t gen{0}; // categories_gen_ of the fetch
+    };
+    mutable std::vector<category_cache_t> categories_;
+    mutable std::mutex categories_mtx_;
 
     virtual size_t get_y(size_t d, const dim_t &i0, size_t n, double *v) const { return 0; }
     virtual size_t get_dy(size_t d, const dim_t &i0, size_t n, double *v) const { return 0; }
     virtual size_t get_x(size_t d, size_t n, double *v) const;
+    // x values [i, i + n) of dim d, used to extend a slice when the data
+    // grows; the default reads from the start, stores with long growing
+    // dims should override it
+    virtual size_t get_x(size_t d, size_t i, size_t n, double *v) const;
 
     friend class DataSlice;
 };
@@ -231,6 +540,37 @@ inline size_t AbstractDataStore::get_x(size_t d, size_t n, double *v) const
     return m;
 }
 
+inline size_t AbstractDataStore::get_x(size_t d, size_t i, size_t n, double *v) const
+{
+    if (i == 0)
+        return get_x(d, n, v);
+    vec_t x(i + n);
+    const size_t m = get_x(d, x.size(), x.data());
+    if (m <= i)
+        return 0;
+    std::copy(x.begin() + i, x.begin() + m, v);
+    return m - i;
+}
+
+inline AbstractDataStore::categories_t AbstractDataStore::categories(size_t d) const
+{
+    if (d >= dim_.size() || !is_x_categorical(d))
+        return categories_t();
+    const uint64_t g = categories_gen_.load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> lock(categories_mtx_);
+    if (categories_.size() != dim_.size())
+        categories_.assign(dim_.size(), category_cache_t());
+    category_cache_t &c = categories_[d];
+    if (!c.x || c.x->size() != dim_[d] || c.gen != g)
+    {
+        auto x = std::make_shared<strvec_t>(dim_[d]);
+        get_x_categorical(d, *x);
+        c.x = x;
+        c.gen = g;
+    }
+    return c.x;
+}
+
 inline AbstractDataStore::dim_t::const_iterator find_max(const AbstractDataStore::dim_t &dim)
 {
     auto jt = dim.begin();
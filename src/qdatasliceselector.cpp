@@ -7,7 +7,9 @@
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QProgressDialog>
 #include <QSlider>
+#include <QSpinBox>
 #include <QToolButton>
 
 QDataSliceSelector::QDataSliceSelector(QWidget *parent)
@@ -67,6 +69,13 @@ QDataSliceSelector::QDataSliceSelector(QWidget *parent)
 
         hbox->addStretch();
 
+        fps_ = new QSpinBox;
+        fps_->setRange(1, 120);
+        fps_->setValue(10);
+        fps_->setSuffix(" fps");
+        fps_->setToolTip("Playback frame rate");
+        hbox->addWidget(fps_);
+
         vbox->addLayout(hbox);
     }
 
@@ -84,10 +93,29 @@ QDataSliceSelector::QDataSliceSelector(QWidget *parent)
     }
 
     vbox->addStretch();
+
+    slice_.set_progress([this](size_t done, size_t total) { return onProgress(done, total); });
+
+    player_ = new FramePlayer(this);
+    connect(player_, &FramePlayer::frameReady, this, &QDataSliceSelector::onFrame);
+    connect(fps_, QOverload<int>::of(&QSpinBox::valueChanged), this, &QDataSliceSelector::onFps);
+}
+
+QDataSliceSelector::~QDataSliceSelector()
+{
+    // the playback threads read the data store
+    player_->stop();
 }
 
 void QDataSliceSelector::clear()
 {
+    if (busy_)
+    {
+        deferredStore_.clear();
+        defer(DeferredAssign);
+        return;
+    }
+    stopPlayback();
     disconnectCtrls();
     clearCtrls();
     slice_.clear();
@@ -96,18 +124,98 @@ void QDataSliceSelector::clear()
 
 void QDataSliceSelector::assign(DataStorePtr D, int dim)
 {
+    if (busy_)
+    {
+        deferredStore_ = D;
+        deferredDim_ = dim;
+        defer(DeferredAssign);
+        return;
+    }
     clear();
+    touch();
     slice_.assign(D, dim);
     initCtrls();
     updateCtrls(All);
     connectCtrls();
+    MemoryAccount::enforceBudget();
     emit sliceReset();
+    runDeferred();
 }
 
 void QDataSliceSelector::updateData()
 {
+    // a reduction of this slice is in progress
+    if (busy_)
+    {
+        defer(DeferredUpdate);
+        return;
+    }
+    // the data store did not change since the slice was read
+    if (slice_.is_current())
+        return;
+    touch();
+    const DataSlice::dim_t dim = slice_.dim();
     slice_.update();
+    // frames are read with the slice shape at the start of playback
+    if (slice_.dim() != dim)
+        stopPlayback();
+    checkCanceled();
+    emit sliceChanged();
+    runDeferred();
+}
+
+void QDataSliceSelector::updateData(size_t d, size_t from, size_t to)
+{
+    // deferred as a full update, the ranges are not merged
+    if (busy_)
+    {
+        defer(DeferredUpdate);
+        return;
+    }
+    if (slice_.is_current())
+        return;
+    touch();
+    const DataSlice::dim_t dim = slice_.dim();
+    slice_.update(d, from, to);
+    if (slice_.dim() != dim)
+        stopPlayback();
+    checkCanceled();
     emit sliceChanged();
+    runDeferred();
+}
+
+size_t QDataSliceSelector::memoryUsage() const
+{
+    return slice_.memory_usage() + labelUsage();
+}
+
+size_t QDataSliceSelector::cacheUsage() const
+{
+    return slice_.unused_capacity() + labelUsage();
+}
+
+size_t QDataSliceSelector::releaseCaches()
+{
+    // the reduction in progress writes to the slice buffers
+    if (busy_)
+        return 0;
+    size_t n = cacheUsage();
+    slice_.shrink();
+    for (auto &e : gridElements)
+        e.valueLbls.clear();
+    return n - cacheUsage();
+}
+
+size_t QDataSliceSelector::labelUsage() const
+{
+    size_t n{0};
+    for (const auto &e : gridElements)
+    {
+        n += e.valueLbls.size() * sizeof(QString);
+        for (const QString &s : e.valueLbls)
+            n += (s.capacity() + 1) * sizeof(QChar);
+    }
+    return n;
 }
 
 void QDataSliceSelector::clearCtrls()
@@ -127,6 +235,9 @@ void QDataSliceSelector::clearCtrls()
         e.label->deleteLater();
         e.slider->deleteLater();
         e.value->deleteLater();
+        e.op->deleteLater();
+        e.window->deleteLater();
+        e.play->deleteLater();
     }
     gridElements.clear();
 
@@ -174,10 +285,28 @@ void QDataSliceSelector::initCtrls()
         e.slider->setTickPosition(QSlider::TicksBothSides);
         e.value = new QLineEdit;
         e.value->setReadOnly(true);
+        e.op = new QComboBox;
+        for (int k = DataReduction::None; k <= DataReduction::Std; ++k)
+            e.op->addItem(DataReduction::name(DataReduction::op_t(k)));
+        e.op->setToolTip("Fixed index or reduction over the dimension");
+        e.window = new QSpinBox;
+        e.window->setPrefix("w=");
+        e.window->setToolTip("Average over a window of w indexes starting at the slider position");
+        e.play = new QToolButton;
+        QIcon icon(":/qdatabrowser/icons/lucide/play.svg");
+        icon.addFile(":/qdatabrowser/icons/lucide/pause.svg", QSize(), QIcon::Normal, QIcon::On);
+        e.play->setIcon(icon);
+        e.play->setCheckable(true);
+        e.play->setAutoRaise(true);
+        e.play->setObjectName("play");
+        e.play->setToolTip("Play the frames along this dimension");
 
         grid->addWidget(e.label, r, 0);
         grid->addWidget(e.slider, r, 1);
         grid->addWidget(e.value, r, 2);
+        grid->addWidget(e.op, r, 3);
+        grid->addWidget(e.window, r, 4);
+        grid->addWidget(e.play, r, 5);
     }
 
     grid->setColumnStretch(1, 1);
@@ -214,12 +343,20 @@ void QDataSliceSelector::updateCtrls(updFlag f)
             e.d = dim_order[d0 + i];
             e.label->setText(dimLabel(e.d));
             size_t n = slice_.dataStore()->dim()[e.d];
-            if (n > 1)
+            DataReduction::op_t op = slice_.reduction(e.d);
+            e.op->setCurrentIndex(op);
+            e.op->setEnabled(slice_.is_numeric() && n > 1);
+            size_t w = slice_.window(e.d);
+            e.window->setRange(1, std::max(n, size_t(1)));
+            e.window->setValue(w);
+            e.window->setEnabled(slice_.is_numeric() && n > 1 && op == DataReduction::None);
+            if (n > 1 && op == DataReduction::None && w < n)
             {
+                // the slider selects the window start
                 e.slider->setEnabled(true);
-                e.slider->setRange(0, n - 1);
+                e.slider->setRange(0, n - w);
                 size_t page = 1;
-                size_t nticks = n;
+                size_t nticks = n - w + 1;
                 while (nticks > maxTicks)
                 {
                     page++;
@@ -236,20 +373,40 @@ void QDataSliceSelector::updateCtrls(updFlag f)
                 e.slider->setEnabled(false);
             }
         }
+        for (auto &e : gridElements)
+            e.play->setEnabled(e.slider->isEnabled() && slice_.is_numeric() && !slice_.is_reduced());
         setSliderLabels();
     case SldrOnly:
         for (int i = 0; i < gridElements.size(); ++i)
         {
             auto &e = gridElements[i];
-            if (e.slider->isEnabled())
+            DataReduction::op_t op = slice_.reduction(e.d);
+            if (op != DataReduction::None)
+            {
+                e.value->setText(QString("%1 of %2")
+                                     .arg(DataReduction::name(op))
+                                     .arg(slice_.dataStore()->dim()[e.d]));
+            }
+            else if (e.slider->isEnabled())
             {
                 size_t k = slice_.i0()[e.d];
+                size_t w = slice_.window(e.d);
                 e.slider->setValue(k);
-                e.value->setText(e.valueLbls.at(k));
+                if (w > 1)
+                    e.value->setText(QString("Mean of %1 ... %2")
+                                         .arg(sliderLabel(e, k))
+                                         .arg(sliderLabel(e, k + w - 1)));
+                else
+                    e.value->setText(sliderLabel(e, k));
+            }
+            else if (slice_.window(e.d) > 1)
+            {
+                e.value->setText(
+                    QString("Mean of %1").arg(slice_.dataStore()->dim()[e.d]));
             }
             else
             {
-                e.value->setText(e.valueLbls.at(0));
+                e.value->setText(sliderLabel(e, 0));
             }
         }
     default:
@@ -271,6 +428,15 @@ void QDataSliceSelector::connectCtrls()
     for (auto &e : gridElements)
     {
         connect(e.slider, &QSlider::valueChanged, this, &QDataSliceSelector::onI0);
+        connect(e.op,
+                QOverload<int>::of(&QComboBox::currentIndexChanged),
+                this,
+                &QDataSliceSelector::onReduce);
+        connect(e.window,
+                QOverload<int>::of(&QSpinBox::valueChanged),
+                this,
+                &QDataSliceSelector::onWindow);
+        connect(e.play, &QToolButton::toggled, this, &QDataSliceSelector::onPlay);
     }
 }
 
@@ -288,6 +454,15 @@ void QDataSliceSelector::disconnectCtrls()
     for (auto &e : gridElements)
     {
         disconnect(e.slider, &QSlider::valueChanged, this, &QDataSliceSelector::onI0);
+        disconnect(e.op,
+                   QOverload<int>::of(&QComboBox::currentIndexChanged),
+                   this,
+                   &QDataSliceSelector::onReduce);
+        disconnect(e.window,
+                   QOverload<int>::of(&QSpinBox::valueChanged),
+                   this,
+                   &QDataSliceSelector::onWindow);
+        disconnect(e.play, &QToolButton::toggled, this, &QDataSliceSelector::onPlay);
     }
 }
 
@@ -297,7 +472,12 @@ void QDataSliceSelector::blockCtrls(bool b)
     cbY->blockSignals(b);
     btExchangeXY->blockSignals(b);
     for (auto &e : gridElements)
+    {
         e.slider->blockSignals(b);
+        e.op->blockSignals(b);
+        e.window->blockSignals(b);
+        e.play->blockSignals(b);
+    }
 }
 
 QString QDataSliceSelector::dimLabel(int d)
@@ -310,34 +490,120 @@ QString QDataSliceSelector::dimLabel(int d)
 
 void QDataSliceSelector::setSliderLabels()
 {
+    DataStorePtr D = slice_.dataStore();
+    for (auto &e : gridElements)
+    {
+        e.categories = D ? D->categories(e.d) : nullptr;
+        e.valueLbls = e.categories ? QStringList() : sliderLabels(e.d);
+    }
+}
+
+// labels of a numeric dim
+QStringList QDataSliceSelector::sliderLabels(int d)
+{
+    QStringList lbls;
     DataStorePtr D = slice_.dataStore();
     if (!D)
-        return;
+        return lbls;
+
+    size_t n = D->dim()[d];
+    AbstractDataStore::vec_t x(n);
+    D->get_x(d, x);
+    for (size_t i = 0; i < n; ++i)
+        lbls.push_back(QString("%1: %2").arg(i).arg(x[i]));
+    return lbls;
+}
 
-    for (int i = 0; i < gridElements.size(); ++i)
+QString QDataSliceSelector::sliderLabel(const gridElement &e, size_t k)
+{
+    if (e.categories)
+        return k < e.categories->size() ? QString("%1: %2").arg(k).arg((*e.categories)[k].c_str())
+                                        : QString();
+    if (k < size_t(e.valueLbls.size()))
+        return e.valueLbls.at(k);
+    // the labels have been released, recreate the one needed
+    QStringList lbls = sliderLabels(e.d);
+    return k < size_t(lbls.size()) ? lbls.at(k) : QString();
+}
+
+bool QDataSliceSelector::onProgress(size_t done, size_t total)
+{
+    if (!progress_)
     {
-        auto &e = gridElements[i];
-        e.valueLbls.clear();
-        size_t n = D->dim()[e.d];
-        if (D->is_x_categorical(e.d))
-        {
-            AbstractDataStore::strvec_t x(n);
-            D->get_x_categorical(e.d, x);
-            for (size_t i = 0; i < n; ++i)
-                e.valueLbls.push_back(QString("%1: %2").arg(i).arg(x[i].c_str()));
-        }
+        progress_ = new QProgressDialog("Computing reduction ...", "Cancel", 0, 1000, this);
+        progress_->setWindowModality(Qt::WindowModal);
+        progress_->setMinimumDuration(500);
+        progress_->reset();
+    }
+
+    // setValue of the modal dialog processes events
+    busy_ = true;
+    progress_->setValue(total ? int(1000.0 * done / total) : 1000);
+    busy_ = false;
+
+    bool canceled = progress_->wasCanceled();
+    if (canceled)
+        progress_->reset();
+    return !canceled;
+}
+
+void QDataSliceSelector::defer(Deferred d)
+{
+    deferred_ = std::max(deferred_, d);
+}
+
+// run the slice change requested during the last reduction, if any
+void QDataSliceSelector::runDeferred()
+{
+    if (busy_ || deferred_ == NoDeferred)
+        return;
+    Deferred d = deferred_;
+    deferred_ = NoDeferred;
+    if (d == DeferredAssign)
+    {
+        DataStorePtr D;
+        D.swap(deferredStore_);
+        if (D)
+            assign(D, deferredDim_);
         else
-        {
-            AbstractDataStore::vec_t x(n);
-            D->get_x(e.d, x);
-            for (size_t i = 0; i < n; ++i)
-                e.valueLbls.push_back(QString("%1: %2").arg(i).arg(x[i]));
-        }
+            clear();
+        return;
     }
+    // controls changed during the reduction were ignored
+    blockCtrls(true);
+    updateCtrls(All);
+    blockCtrls(false);
+    if (d == DeferredUpdate)
+        updateData();
+}
+
+// if the last reduction was canceled, switch back to fixed index & no window
+void QDataSliceSelector::checkCanceled()
+{
+    if (!slice_.canceled())
+        return;
+
+    DataStorePtr D = slice_.dataStore();
+    for (size_t d = 0; D && d < D->ndim(); ++d)
+    {
+        slice_.set_reduction(d, DataReduction::None);
+        slice_.set_window(d, 1);
+    }
+    slice_.update();
+
+    blockCtrls(true);
+    updateCtrls(All);
+    blockCtrls(false);
 }
 
 void QDataSliceSelector::onX(int new_dx)
 {
+    if (busy_)
+    {
+        defer(DeferredCtrls);
+        return;
+    }
+    stopPlayback();
     blockCtrls(true);
 
     updFlag f = All;
@@ -364,11 +630,20 @@ void QDataSliceSelector::onX(int new_dx)
 
     blockCtrls(false);
 
+    checkCanceled();
+
     emit sliceChanged();
+    runDeferred();
 }
 
 void QDataSliceSelector::onY(int new_dy)
 {
+    if (busy_)
+    {
+        defer(DeferredCtrls);
+        return;
+    }
+    stopPlayback();
     blockCtrls(true);
 
     updFlag f = All;
@@ -388,11 +663,20 @@ void QDataSliceSelector::onY(int new_dy)
 
     blockCtrls(false);
 
+    checkCanceled();
+
     emit sliceChanged();
+    runDeferred();
 }
 
 void QDataSliceSelector::onExchangeXY(bool)
 {
+    if (busy_)
+    {
+        defer(DeferredCtrls);
+        return;
+    }
+    stopPlayback();
     blockCtrls(true);
 
     auto i0 = slice_.i0();
@@ -404,11 +688,20 @@ void QDataSliceSelector::onExchangeXY(bool)
 
     blockCtrls(false);
 
+    checkCanceled();
+
     emit sliceChanged();
+    runDeferred();
 }
 
 void QDataSliceSelector::onI0(int v)
 {
+    if (busy_)
+    {
+        defer(DeferredCtrls);
+        return;
+    }
+    stopPlayback();
     blockCtrls(true);
 
     auto i0 = slice_.i0();
@@ -427,5 +720,151 @@ void QDataSliceSelector::onI0(int v)
 
     blockCtrls(false);
 
+    checkCanceled();
+
     emit sliceChanged();
+    runDeferred();
+}
+
+void QDataSliceSelector::onReduce(int op)
+{
+    if (busy_)
+    {
+        defer(DeferredCtrls);
+        return;
+    }
+    stopPlayback();
+    blockCtrls(true);
+
+    for (int i = 0; i < gridElements.size(); ++i)
+    {
+        gridElement &e = gridElements[i];
+        if (sender() == e.op)
+        {
+            slice_.set_reduction(e.d, DataReduction::op_t(op));
+            slice_.update();
+            break;
+        }
+    }
+
+    updateCtrls(All);
+
+    blockCtrls(false);
+
+    checkCanceled();
+
+    emit sliceChanged();
+    runDeferred();
+}
+
+void QDataSliceSelector::onWindow(int w)
+{
+    if (busy_)
+    {
+        defer(DeferredCtrls);
+        return;
+    }
+    stopPlayback();
+    blockCtrls(true);
+
+    for (int i = 0; i < gridElements.size(); ++i)
+    {
+        gridElement &e = gridElements[i];
+        if (sender() == e.window)
+        {
+            slice_.set_window(e.d, w);
+            slice_.update();
+            break;
+        }
+    }
+
+    updateCtrls(All);
+
+    blockCtrls(false);
+
+    checkCanceled();
+
+    emit sliceChanged();
+    runDeferred();
+}
+
+void QDataSliceSelector::stopPlayback()
+{
+    player_->stop();
+    for (auto &e : gridElements)
+    {
+        e.play->blockSignals(true);
+        e.play->setChecked(false);
+        e.play->blockSignals(false);
+    }
+}
+
+void QDataSliceSelector::onPlay(bool on)
+{
+    if (busy_)
+    {
+        QToolButton *bt = qobject_cast<QToolButton *>(sender());
+        if (bt)
+        {
+            bt->blockSignals(true);
+            bt->setChecked(!on);
+            bt->blockSignals(false);
+        }
+        return;
+    }
+    QObject *bt = sender();
+    stopPlayback();
+    if (!on)
+        return;
+
+    for (auto &e : gridElements)
+    {
+        if (bt != e.play)
+            continue;
+        e.play->blockSignals(true);
+        e.play->setChecked(true);
+        e.play->blockSignals(false);
+
+        // frames from the current position, looping over the dim
+        // the workers read through a copy of the slice layout, the slice
+        // itself may be updated meanwhile
+        DataSlice::frame_reader r = slice_.reader();
+        size_t d = e.d;
+        size_t n = e.slider->maximum() + 1;
+        size_t k0 = slice_.i0()[d];
+        DataSlice::dim_t i0 = slice_.i0();
+        player_->setFps(fps_->value());
+        player_->start(
+            [r, i0, d, n, k0](FramePlayer::Frame &f) {
+                f.i0 = i0;
+                f.i0[d] = (k0 + f.t) % n;
+                if (!r.fetch(f.i0, f.y, f.dy))
+                    f.y.clear();
+            },
+            preparer_ ? preparer_() : FramePlayer::prepare_t());
+        break;
+    }
+}
+
+// GUI thread: show the frame & move the slider along
+void QDataSliceSelector::onFrame(FramePlayer::FramePtr f)
+{
+    if (busy_)
+        return;
+    // the data store was resized during playback
+    if (f->y.empty())
+    {
+        stopPlayback();
+        return;
+    }
+    slice_.set_frame(f->i0, f->y, f->dy);
+    blockCtrls(true);
+    updateCtrls(SldrOnly);
+    blockCtrls(false);
+    emit frameChanged(f);
+}
+
+void QDataSliceSelector::onFps(int fps)
+{
+    player_->setFps(fps);
 }
@@ -2,6 +2,7 @@
 #define QDATASLICESELECTOR_H
 
 #include "dataslice.h"
+#include "frameplayer.h"
 
 #include <QWidget>
 
@@ -11,24 +12,46 @@ class QGridLayout;
 class QLabel;
 class QSlider;
 class QLineEdit;
+class QProgressDialog;
+class QSpinBox;
 class QToolButton;
 
-class QDataSliceSelector : public QWidget
+class QDataSliceSelector : public QWidget, public MemoryConsumer
 {
     Q_OBJECT
 
 public:
     explicit QDataSliceSelector(QWidget *parent = nullptr);
+    ~QDataSliceSelector();
 
     void clear();
     void assign(DataStorePtr D, int dim = 1);
 
     DataSlice *slice() { return &slice_; }
+    // re-read the slice & emit sliceChanged(), unless the data store
+    // version is the one the slice was read at
     void updateData();
+    // values changed at [from, to) of dim d of the slice data store
+    void updateData(size_t d, size_t from, size_t to);
+
+    // frame playback along a hidden dim, started with its play button
+    FramePlayer *player() const { return player_; }
+    void stopPlayback();
+    // returns the function that prepares frames for the view, called
+    // when playback starts
+    void setFramePreparer(const std::function<FramePlayer::prepare_t()> &f) { preparer_ = f; }
+
+    // memory accounting
+    size_t memoryUsage() const override;
+    size_t cacheUsage() const override;
+    size_t releaseCaches() override;
+    size_t labelUsage() const;
 
 signals:
     void sliceReset();
     void sliceChanged();
+    // a playback frame is now in the slice
+    void frameChanged(FramePlayer::FramePtr f);
 
 protected:
     // data
@@ -38,6 +61,21 @@ protected:
     QComboBox *cbX;
     QComboBox *cbY;
     QToolButton *btExchangeXY;
+    QProgressDialog *progress_{nullptr};
+    // a reduction is in progress & the progress dialog processes events:
+    // the slice must not change, requested changes are deferred until the
+    // reduction ends, the latest one superseding the others
+    bool busy_{false};
+    enum Deferred { NoDeferred, DeferredCtrls, DeferredUpdate, DeferredAssign };
+    Deferred deferred_{NoDeferred};
+    DataStorePtr deferredStore_; // null for clear()
+    int deferredDim_{1};
+    void defer(Deferred d);
+
+    // playback
+    QSpinBox *fps_;
+    FramePlayer *player_;
+    std::function<FramePlayer::prepare_t()> preparer_;
 
     // grid of dims
     static const int maxTicks = 15;
@@ -49,7 +87,12 @@ protected:
         QLabel *label;
         QSlider *slider;
         QLineEdit *value;
+        QComboBox *op;
+        QSpinBox *window;
+        QToolButton *play;
         QStringList valueLbls;
+        // categorical dims: labels are made on demand from the categories
+        AbstractDataStore::categories_t categories;
     };
     QVector<gridElement> gridElements;
     void clearCtrls();
@@ -64,12 +107,22 @@ protected:
     void blockCtrls(bool b);
     QString dimLabel(int d);
     void setSliderLabels();
+    QStringList sliderLabels(int d);
+    QString sliderLabel(const gridElement &e, size_t k);
+    bool onProgress(size_t done, size_t total);
+    void checkCanceled();
+    void runDeferred();
 
 protected slots:
     void onX(int new_dx);
     void onY(int d);
     void onExchangeXY(bool);
     void onI0(int v);
+    void onReduce(int op);
+    void onWindow(int w);
+    void onPlay(bool on);
+    void onFrame(FramePlayer::FramePtr f);
+    void onFps(int fps);
 };
 
 #endif // QDATASLICESELECTOR_H
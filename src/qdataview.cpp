@@ -1,5 +1,6 @@
 #include "qdataview.h"
 
+#include <QInputDialog>
 #include <QLabel>
 #include <QMenu>
 #include <QPlainTextEdit>
@@ -8,7 +9,12 @@
 #include <QVBoxLayout>
 #include <QMatPlotWidget>
 
+#include "datastats.h"
 #include "qdatasliceselector.h"
+#include "qheatmapwidget.h"
+
+#include <limits>
+#include <thread>
 
 QAbstractDataView::QAbstractDataView(QWidget *parent)
     : QWidget{parent}
@@ -27,6 +33,11 @@ void QAbstractDataView::updateView()
     emit viewUpdated();
 }
 
+void QAbstractDataView::showFrame(FramePlayer::FramePtr)
+{
+    updateView();
+}
+
 /************* QTabularDataView *******************/
 
 class QDataTableModel : public QAbstractTableModel
@@ -41,6 +52,7 @@ public:
     {
         beginResetModel();
         slice_ = s;
+        text_.clear();
         endResetModel();
     }
 
@@ -60,9 +72,8 @@ public:
     {
         if (!index.isValid() || role != Qt::DisplayRole || slice_ == nullptr || slice_->empty())
             return QVariant();
-        return slice_->is_numeric()
-                   ? QVariant((*slice_)(index.row(), index.column()))
-                   : QVariant(slice_->text_data(index.row(), index.column()).c_str());
+        return slice_->is_numeric() ? QVariant((*slice_)(index.row(), index.column()))
+                                    : QVariant(text(index.row(), index.column()));
     }
     QVariant headerData(int i,
                         Qt::Orientation orientation,
@@ -91,8 +102,28 @@ public:
 
 private:
     DataSlice *slice_{nullptr};
+    // text values converted on demand, once per distinct value
+    mutable std::vector<QString> text_;
+    mutable std::vector<bool> converted_;
 
     bool validSlice() const { return slice_ && !slice_->empty(); }
+
+    QString text(size_t i, size_t j) const
+    {
+        if (text_.empty())
+        {
+            text_.resize(slice_->text_count());
+            converted_.assign(text_.size(), false);
+        }
+        uint32_t id = slice_->text_id(i, j);
+        if (!converted_[id])
+        {
+            std::string_view t = slice_->text(id);
+            text_[id] = QString::fromUtf8(t.data(), int(t.size()));
+            converted_[id] = true;
+        }
+        return text_[id];
+    }
 };
 
 QTabularDataView::QTabularDataView(QWidget *parent)
@@ -140,7 +171,10 @@ void QTabularDataView::updateView_()
         if (slice_->is_numeric())
             scalarView_->setPlainText(QString::number((*slice_)(0, 0)));
         else
-            scalarView_->setPlainText(slice_->text_data(0, 0).c_str());
+        {
+            std::string_view t = slice_->text_data(0, 0);
+            scalarView_->setPlainText(QString::fromUtf8(t.data(), int(t.size())));
+        }
         stack_->setCurrentIndex(0);
     }
     else
@@ -190,13 +224,27 @@ void QPlotDataView::setData(DataSlice *s)
 
 void QPlotDataView::updateView_()
 {
+    // data appended to the line: extend the decimated line with the new
+    // points only & replot it
+    if (slice_ && !slice_->empty() && slice_->ndim() == 1 && type_ == QDataBrowser::Line
+        && decimator_.size() && decimator_.size() == slice_->appended_from())
+    {
+        size_t n0 = decimator_.size();
+        decimator_.append(slice_->x().data() + n0,
+                          slice_->data().data() + n0,
+                          slice_->data().size() - n0);
+        linePlot->clear();
+        plotDecimated_();
+        return;
+    }
+
+    decimator_.clear();
     linePlot->clear();
     linePlot->setXlabel("");
     linePlot->setYlabel("");
     linePlot->setTitle("");
 
-    bool haserr = slice_ && !slice_->empty() && slice_->hasErrors();
-    if (!haserr && type_ == QDataBrowser::ErrorBar)
+    if (!supportsPlotType(type_))
         type_ = QDataBrowser::Line;
 
     if (!slice_ || slice_->empty())
@@ -207,7 +255,8 @@ void QPlotDataView::updateView_()
     switch (type_)
     {
     case QDataBrowser::Line:
-        linePlot->plot(slice_->x(), slice_->data());
+        decimator_.append(slice_->x().data(), slice_->data().data(), slice_->data().size());
+        plotDecimated_();
         break;
     case QDataBrowser::Points:
         linePlot->plot(slice_->x(), slice_->data(), "o");
@@ -228,6 +277,13 @@ void QPlotDataView::updateView_()
     linePlot->setTitle(slice_->description().c_str());
 }
 
+void QPlotDataView::plotDecimated_()
+{
+    std::vector<double> x, y;
+    decimator_.line(x, y);
+    linePlot->plot(x, y);
+}
+
 void QPlotDataView::createOptionsMenu()
 {
     optionsMenu_ = new QMenu((QWidget *)this);
@@ -319,10 +375,222 @@ void QPlotDataView::updateOptionsMenu()
 
     int k = 0;
     for (QAction *a : plotTypeGroup->actions())
+    {
+        a->setEnabled(supportsPlotType(QDataBrowser::PlotType(k)));
         a->setChecked(type_ == k++);
+    }
+}
 
+bool QPlotDataView::supportsPlotType(QDataBrowser::PlotType t) const
+{
     bool haserr = slice_ && !slice_->empty() && slice_->hasErrors();
-    plotTypeGroup->actions().last()->setEnabled(haserr);
+    return t != QDataBrowser::ErrorBar || haserr;
+}
+
+/************ QTracesDataView  *****************/
+
+namespace {
+
+// total number of plotted points shared by the traces
+const size_t tracePointBudget = 1 << 18;
+// below this number of values the traces are decimated in the calling thread
+const size_t min_parallel_traces_size = 1 << 18;
+
+} // namespace
+
+QTracesDataView::QTracesDataView(QWidget *parent)
+    : QPlotDataView(parent)
+{
+    optionsMenu_->addSeparator();
+
+    QMenu *m = optionsMenu_->addMenu("Traces");
+    QAction *a;
+    offsetGroup = new QActionGroup(this);
+    a = m->addAction("Overlay", this, [this]() { setOffset(false); });
+    a->setCheckable(true);
+    offsetGroup->addAction(a);
+    a = m->addAction("Offset (waterfall)", this, [this]() { setOffset(true); });
+    a->setCheckable(true);
+    offsetGroup->addAction(a);
+    m->addSeparator();
+    maxTracesGroup = new QActionGroup(this);
+    for (int n : {16, 64, 256, 1024, 0})
+    {
+        a = m->addAction(n ? QString("Max %1 traces").arg(n) : QString("All traces"),
+                         this,
+                         [this, n]() { setMaxTraces(n); });
+        a->setCheckable(true);
+        a->setData(n);
+        maxTracesGroup->addAction(a);
+    }
+    connect(optionsMenu_, &QMenu::aboutToShow, this, &QTracesDataView::updateTracesMenu);
+}
+
+QIcon QTracesDataView::icon() const
+{
+    return QIcon(":/qdatabrowser/icons/lucide/chart-line.svg");
+}
+
+void QTracesDataView::setOffset(bool on)
+{
+    offset_ = on;
+    updateView_();
+}
+
+void QTracesDataView::setMaxTraces(int n)
+{
+    maxTraces_ = std::max(n, 0);
+    updateView_();
+}
+
+void QTracesDataView::updateTracesMenu()
+{
+    offsetGroup->actions().at(offset_ ? 1 : 0)->setChecked(true);
+    for (QAction *a : maxTracesGroup->actions())
+        a->setChecked(a->data().toInt() == maxTraces_);
+}
+
+bool QTracesDataView::supportsPlotType(QDataBrowser::PlotType t) const
+{
+    return t == QDataBrowser::Line || t == QDataBrowser::Points
+           || t == QDataBrowser::LineAndPoints;
+}
+
+// decimate the traces traces_[idx[k]] from the slice data
+void QTracesDataView::decimate_(const std::vector<size_t> &idx)
+{
+    const size_t nx = slice_->dim()[0];
+    const double *x = slice_->x().data();
+    const double *y = slice_->data().data();
+    auto work = [&](size_t k0, size_t k1) {
+        for (size_t k = k0; k < k1; ++k)
+        {
+            LineDecimator &t = traces_[idx[k]];
+            t.clear();
+            t.append(x, y + traceRows_[idx[k]] * nx, nx);
+        }
+    };
+
+    size_t nthreads = std::min(size_t(DataReduction::maxThreads()), idx.size());
+    if (idx.size() * nx < min_parallel_traces_size)
+        nthreads = 1;
+    if (nthreads <= 1)
+    {
+        work(0, idx.size());
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; ++t)
+        threads.emplace_back(work, idx.size() * t / nthreads, idx.size() * (t + 1) / nthreads);
+    for (std::thread &th : threads)
+        th.join();
+}
+
+void QTracesDataView::updateView_()
+{
+    linePlot->clear();
+    linePlot->setXlabel("");
+    linePlot->setYlabel("");
+    linePlot->setTitle("");
+
+    if (!slice_ || slice_->empty() || !slice_->is_numeric())
+    {
+        traces_.clear();
+        traceRows_.clear();
+        return;
+    }
+    if (!supportsPlotType(type_))
+        type_ = QDataBrowser::Line;
+
+    const size_t nx = slice_->dim()[0];
+    const size_t ny = slice_->ndim() > 1 ? slice_->dim()[1] : 1;
+
+    // every k-th row, up to maxTraces_
+    size_t step = maxTraces_ ? (ny + maxTraces_ - 1) / maxTraces_ : 1;
+    std::vector<size_t> rows;
+    for (size_t j = 0; j < ny; j += step)
+        rows.push_back(j);
+
+    // markers are not decimated, every point is drawn
+    size_t buckets = type_ == QDataBrowser::Line
+                         ? std::max(tracePointBudget / 2 / rows.size(), size_t(16))
+                         : nx;
+
+    // same traces & decimation: redo only the changed rows
+    std::vector<size_t> redo;
+    if (rows == traceRows_ && traces_.size() == rows.size() && traces_[0].maxBuckets() == buckets
+        && traces_[0].size() == nx && !slice_->all_rows_changed())
+    {
+        for (const auto &r : slice_->changed_rows())
+        {
+            auto it = std::lower_bound(rows.begin(), rows.end(), r.first);
+            for (; it != rows.end() && *it < r.second; ++it)
+                redo.push_back(it - rows.begin());
+        }
+    }
+    else
+    {
+        traceRows_ = rows;
+        traces_.assign(rows.size(), LineDecimator(buckets));
+        for (size_t k = 0; k < rows.size(); ++k)
+            redo.push_back(k);
+    }
+    decimate_(redo);
+
+    // concatenate the traces, separated by NaN
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<std::vector<double>> tx(traces_.size()), ty(traces_.size());
+    double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+    size_t n = 0;
+    for (size_t k = 0; k < traces_.size(); ++k)
+    {
+        traces_[k].line(tx[k], ty[k]);
+        n += tx[k].size() + 1;
+        for (double v : ty[k])
+        {
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+    }
+    double dy = offset_ && traces_.size() > 1 && hi > lo ? (hi - lo) / (traces_.size() - 1) : 0.;
+
+    std::vector<double> x, y;
+    x.reserve(n);
+    y.reserve(n);
+    for (size_t k = 0; k < traces_.size(); ++k)
+    {
+        if (k)
+        {
+            x.push_back(nan);
+            y.push_back(nan);
+        }
+        x.insert(x.end(), tx[k].begin(), tx[k].end());
+        for (double v : ty[k])
+            y.push_back(v + k * dy);
+    }
+
+    switch (type_)
+    {
+    case QDataBrowser::Points:
+        linePlot->plot(x, y, "o");
+        break;
+    case QDataBrowser::LineAndPoints:
+        linePlot->plot(x, y, "o-");
+        break;
+    default:
+        linePlot->plot(x, y);
+        break;
+    }
+    linePlot->setXlabel(slice_->dim_desc(0).c_str());
+    if (slice_->ndim() > 1)
+        linePlot->setTitle(QString("%1 (%2 of %3 %4 traces)")
+                               .arg(slice_->description().c_str())
+                               .arg(rows.size())
+                               .arg(ny)
+                               .arg(slice_->dim_name(1).c_str()));
+    else
+        linePlot->setTitle(slice_->description().c_str());
 }
 
 /************ QHeatMapDataView  *****************/
@@ -330,15 +598,22 @@ void QPlotDataView::updateOptionsMenu()
 QHeatMapDataView::QHeatMapDataView(QWidget *parent)
     : QAbstractDataView(parent)
 {
-    heatMap = new QMatPlotWidget;
+    heatMap = new QHeatMapWidget;
     heatMap->setStyleSheet("background: white");
+    // the slice buffer, looked up on every remap as it may have been
+    // reallocated or reassigned since it was shown
+    heatMap->setSource([this]() -> const double * {
+        if (!slice_ || slice_->empty() || !slice_->is_numeric()
+            || slice_->data().size() != size_t(heatMap->nx()) * heatMap->ny())
+            return nullptr;
+        return slice_->data().data();
+    });
 
     /* create layout */
     QVBoxLayout *vbox = new QVBoxLayout;
     setLayout(vbox);
     vbox->addWidget(heatMap);
 
-    cmap_ = QMatPlotWidget::Viridis;
     createOptionsMenu();
     connect(optionsMenu_, &QMenu::aboutToShow, this, &QHeatMapDataView::updateOptionsMenu);
 }
@@ -354,22 +629,177 @@ void QHeatMapDataView::exportImage() const
     heatMap->exportToFile("export.pdf", QSize(160, 120));
 }
 
+namespace {
+
+// a playback frame mapped to colors & the color map settings used
+struct MappedFrame
+{
+    QImage image;
+    ColorMap::Palette palette;
+    ColorMap::Scale scale;
+    bool autoLimits;
+    double lo, hi;
+};
+
+} // namespace
+
+// map the frames to colors in the player threads, with a copy of the
+// color map at the start of playback
+FramePlayer::prepare_t QHeatMapDataView::framePreparer() const
+{
+    if (!slice_ || slice_->empty() || !slice_->is_numeric())
+        return FramePlayer::prepare_t();
+    int nx = slice_->dim()[0], ny = slice_->ndim() > 1 ? slice_->dim()[1] : 1;
+    ColorMap cmap = heatMap->colorMap();
+    bool autoLimits = heatMap->autoLimits();
+    return [cmap, autoLimits, nx, ny](FramePlayer::Frame &f) {
+        if (f.y.size() != size_t(nx) * ny)
+            return;
+        ColorMap c(cmap);
+        double lo, hi;
+        if (autoLimits && ColorMap::range(f.y.data(), f.y.size(), c.scale(), lo, hi))
+            c.setLimits(lo, hi);
+        std::shared_ptr<MappedFrame> m(new MappedFrame{QHeatMapWidget::mapImage(c, f.y.data(), nx, ny),
+                                                       c.palette(),
+                                                       c.scale(),
+                                                       autoLimits,
+                                                       c.lo(),
+                                                       c.hi()});
+        f.prepared = m;
+    };
+}
+
+// show a mapped frame if the color settings have not changed meanwhile
+void QHeatMapDataView::showFrame(FramePlayer::FramePtr f)
+{
+    auto m = std::static_pointer_cast<MappedFrame>(f->prepared);
+    const ColorMap &c = heatMap->colorMap();
+    if (m && slice_ && heatMap->nx() == m->image.width() && heatMap->ny() == m->image.height()
+        && m->palette == c.palette() && m->scale == c.scale()
+        && m->autoLimits == heatMap->autoLimits()
+        && (m->autoLimits || (m->lo == c.lo() && m->hi == c.hi())))
+    {
+        heatMap->setMappedData(heatMap->nx(), heatMap->ny(), m->image, m->lo, m->hi);
+        emit viewUpdated();
+        return;
+    }
+    updateView();
+}
+
+void QHeatMapDataView::setColorMap(ColorMap::Palette p)
+{
+    heatMap->setColorMap(p);
+}
+
+void QHeatMapDataView::setColorScale(ColorMap::Scale s)
+{
+    heatMap->setColorScale(s);
+    // the dataset limits depend on the scale
+    if (limits_ == DatasetLimits)
+        applyLimits();
+}
+
+void QHeatMapDataView::setLimitsMode(QHeatMapDataView::Limits l)
+{
+    limits_ = l;
+    applyLimits();
+}
+
+void QHeatMapDataView::setFixedLimits(double lo, double hi)
+{
+    if (!(hi > lo))
+        return;
+    fixed_[0] = lo;
+    fixed_[1] = hi;
+    limits_ = FixedLimits;
+    applyLimits();
+}
+
+void QHeatMapDataView::setDatasetStats(const DataStats *s)
+{
+    hasDatasetRange_ = s && s->count;
+    if (hasDatasetRange_)
+    {
+        dataset_[0] = s->min;
+        dataset_[1] = s->max;
+        // smallest positive value, to the resolution of the fine histogram
+        datasetPos_[0] = s->min;
+        datasetPos_[1] = s->max;
+        for (size_t j = 0; s->min <= 0. && j < s->hist.size(); ++j)
+        {
+            double x = s->hist_lo + j * s->hist_width;
+            if (x > 0. && s->hist[j])
+            {
+                datasetPos_[0] = x;
+                break;
+            }
+        }
+    }
+    if (limits_ == DatasetLimits)
+        applyLimits();
+}
+
+// set the color limits of the heat map according to the mode
+void QHeatMapDataView::applyLimits()
+{
+    switch (limits_)
+    {
+    case FixedLimits:
+        heatMap->setLimits(fixed_[0], fixed_[1]);
+        break;
+    case DatasetLimits:
+        if (hasDatasetRange_)
+        {
+            if (heatMap->colorMap().scale() == ColorMap::Log)
+                heatMap->setLimits(datasetPos_[0], datasetPos_[1]);
+            else
+                heatMap->setLimits(dataset_[0], dataset_[1]);
+            break;
+        }
+        // not yet available, fall through to the slice limits
+    default:
+        heatMap->setAutoLimits(true);
+        break;
+    }
+}
+
 void QHeatMapDataView::updateView_()
 {
-    heatMap->clear();
+    // same slice shape: recolor only the rows changed by the last update,
+    // if any
+    if (slice_ && !slice_->empty() && slice_->is_numeric() && !slice_->all_rows_changed()
+        && heatMap->nx() == int(slice_->dim()[0])
+        && heatMap->ny() == int(slice_->ndim() > 1 ? slice_->dim()[1] : 1) && heatMap->data())
+    {
+        heatMap->updateRows(slice_->changed_rows());
+        return;
+    }
+
     heatMap->setXlabel("");
     heatMap->setYlabel("");
     heatMap->setTitle("");
 
-    if (!slice_ || slice_->empty())
+    if (!slice_ || slice_->empty() || !slice_->is_numeric())
     {
+        heatMap->clear();
         return;
     }
 
     int ndim = slice_->ndim();
     auto dim = slice_->dim();
+    int nx = dim[0], ny = ndim > 1 ? dim[1] : 1;
+
+    if (slice_->is_x_categorical(0) || slice_->x().empty())
+        heatMap->setXRange(0, nx - 1);
+    else
+        heatMap->setXRange(slice_->x().front(), slice_->x().back());
+    if (ndim < 2 || slice_->is_x_categorical(1) || slice_->y().empty())
+        heatMap->setYRange(0, ny - 1);
+    else
+        heatMap->setYRange(slice_->y().front(), slice_->y().back());
 
-    heatMap->imagesc(slice_->data(), dim[0]);
+    // with fixed or dataset limits there is no min/max pass over the data
+    heatMap->setData(nx, ny);
     heatMap->setXlabel(slice_->dim_name(0).c_str());
     if (ndim > 1)
         heatMap->setYlabel(slice_->dim_name(1).c_str());
@@ -385,51 +815,40 @@ void QHeatMapDataView::createOptionsMenu()
 
     m = optionsMenu_->addMenu("Colormap");
     colormapGroup = new QActionGroup(this);
-    a = m->addAction("Viridis", heatMap, [this]()
-                     {
-        this->heatMap->setColorMap(QMatPlotWidget::Viridis);
-        cmap_ = QMatPlotWidget::Viridis;
-        updateView_(); });
-    a->setCheckable(true);
-    a->setChecked(cmap_ == QMatPlotWidget::Viridis);
-    colormapGroup->addAction(a);
-    a = m->addAction("Turbo", heatMap, [this]()
-                     {
-        this->heatMap->setColorMap(QMatPlotWidget::Turbo);
-        cmap_ = QMatPlotWidget::Turbo;
-        updateView_(); });
-    a->setCheckable(true);
-    a->setChecked(cmap_ == QMatPlotWidget::Turbo);
-    colormapGroup->addAction(a);
-    a = m->addAction("Jet", heatMap, [this]()
-                     {
-        this->heatMap->setColorMap(QMatPlotWidget::Jet);
-        cmap_ = QMatPlotWidget::Jet;
-        updateView_(); });
-    a->setCheckable(true);
-    a->setChecked(cmap_ == QMatPlotWidget::Jet);
-    colormapGroup->addAction(a);
-    a = m->addAction("Gray", heatMap, [this]()
-                     {
-        this->heatMap->setColorMap(QMatPlotWidget::Gray);
-        cmap_ = QMatPlotWidget::Gray;
-        updateView_(); });
-    a->setCheckable(true);
-    a->setChecked(cmap_ == QMatPlotWidget::Gray);
-    colormapGroup->addAction(a);
+    const char *cmapNames[] = {"Viridis", "Turbo", "Jet", "Gray"};
+    for (int k = ColorMap::Viridis; k <= ColorMap::Gray; ++k)
+    {
+        a = m->addAction(cmapNames[k], this, [this, k]() { setColorMap(ColorMap::Palette(k)); });
+        a->setCheckable(true);
+        a->setChecked(heatMap->colorMap().palette() == k);
+        colormapGroup->addAction(a);
+    }
 
     // optionsMenu_->addSeparator();
 
     m = optionsMenu_->addMenu("Color scale");
     linLogGroup = new QActionGroup(this);
-    a = m->addAction(QString("Linear Scale"));
+    const char *scaleNames[] = {"Linear Scale", "Log Scale", "Symmetric Log Scale"};
+    for (int k = ColorMap::Linear; k <= ColorMap::SymLog; ++k)
+    {
+        a = m->addAction(scaleNames[k], this, [this, k]() { setColorScale(ColorMap::Scale(k)); });
+        a->setCheckable(true);
+        a->setChecked(heatMap->colorMap().scale() == k);
+        linLogGroup->addAction(a);
+    }
+
+    m = optionsMenu_->addMenu("Color limits");
+    limitsGroup = new QActionGroup(this);
+    a = m->addAction("Slice min - max", this, [this]() { setLimitsMode(SliceLimits); });
     a->setCheckable(true);
-    a->setChecked(true);
-    linLogGroup->addAction(a);
-    a = m->addAction(QString("Log Scale"));
+    limitsGroup->addAction(a);
+    a = m->addAction("Dataset min - max", this, [this]() { setLimitsMode(DatasetLimits); });
     a->setCheckable(true);
-    a->setChecked(false);
-    linLogGroup->addAction(a);
+    limitsGroup->addAction(a);
+    a = m->addAction("Fixed ...", this, SLOT(onSetLimits()));
+    a->setCheckable(true);
+    limitsGroup->addAction(a);
+    limitsGroup->actions().at(limits_)->setChecked(true);
 
     // optionsMenu_->addSeparator();
 
@@ -442,6 +861,221 @@ void QHeatMapDataView::updateOptionsMenu()
 {
     int k = 0;
     for (QAction *a : colormapGroup->actions())
-        a->setChecked(cmap_ == k++);
+        a->setChecked(heatMap->colorMap().palette() == k++);
+    k = 0;
+    for (QAction *a : linLogGroup->actions())
+        a->setChecked(heatMap->colorMap().scale() == k++);
+    limitsGroup->actions().at(limits_)->setChecked(true);
+    limitsGroup->actions().at(DatasetLimits)->setEnabled(hasDatasetRange_);
     gridAct->setChecked(heatMap->grid());
 }
+
+void QHeatMapDataView::onSetLimits()
+{
+    double lo = heatMap->colorMap().lo(), hi = heatMap->colorMap().hi();
+
+    bool ok;
+    lo = QInputDialog::getDouble(this, "Color limits", "Min", lo, -1e300, 1e300, 6, &ok);
+    if (ok)
+        hi = QInputDialog::getDouble(this, "Color limits", "Max", std::max(hi, lo), lo, 1e300, 6, &ok);
+    if (ok)
+        setFixedLimits(lo, hi);
+    else
+        limitsGroup->actions().at(limits_)->setChecked(true);
+}
+
+/************ QHistogramDataView  *****************/
+
+QHistogramDataView::QHistogramDataView(QWidget *parent)
+    : QAbstractDataView(parent)
+{
+    histPlot = new QMatPlotWidget;
+    histPlot->setStyleSheet("background: white");
+
+    /* create layout */
+    QVBoxLayout *vbox = new QVBoxLayout;
+    setLayout(vbox);
+    vbox->addWidget(histPlot);
+
+    createOptionsMenu();
+    connect(optionsMenu_, &QMenu::aboutToShow, this, &QHistogramDataView::updateOptionsMenu);
+}
+
+QHistogramDataView::~QHistogramDataView() {}
+
+QIcon QHistogramDataView::icon() const
+{
+    return QIcon(":/qdatabrowser/icons/lucide/chart-column.svg");
+}
+
+void QHistogramDataView::exportImage() const
+{
+    // Export the plot to 160x120mm page
+    histPlot->exportToFile("export.pdf", QSize(160, 120));
+}
+
+void QHistogramDataView::setSource(QHistogramDataView::Source s)
+{
+    source_ = s;
+    replot();
+}
+
+void QHistogramDataView::setBinCount(int n)
+{
+    nbins_ = std::max(n, 1);
+    replot();
+}
+
+void QHistogramDataView::setRange(double lo, double hi)
+{
+    if (!(hi > lo))
+        return;
+    range_[0] = lo;
+    range_[1] = hi;
+    autoRange_ = false;
+    replot();
+}
+
+void QHistogramDataView::setAutoRange(bool on)
+{
+    autoRange_ = on;
+    replot();
+}
+
+void QHistogramDataView::setDatasetStats(const DataStats *s)
+{
+    if (s)
+        datasetStats_.reset(new DataStats(*s));
+    else
+        datasetStats_.reset();
+    if (source_ == DatasetValues)
+        replot();
+}
+
+void QHistogramDataView::updateView_()
+{
+    // the slice changed, its values are binned again when they are shown
+    sliceStats_.reset();
+    replot();
+}
+
+const DataStats *QHistogramDataView::stats_()
+{
+    if (source_ == DatasetValues)
+        return datasetStats_.get();
+
+    // bin the slice values once into a fine histogram
+    if (!sliceStats_ && slice_ && !slice_->empty() && slice_->is_numeric())
+    {
+        sliceStats_.reset(new DataStats);
+        DataStats::compute(slice_->data().data(), slice_->data().size(), *sliceStats_);
+    }
+    return sliceStats_.get();
+}
+
+void QHistogramDataView::replot()
+{
+    histPlot->clear();
+    histPlot->setXlabel("");
+    histPlot->setYlabel("");
+    histPlot->setTitle("");
+
+    const DataStats *S = stats_();
+    if (!slice_ || slice_->empty() || !S || S->count == 0)
+        return;
+
+    double lo = autoRange_ ? S->min : range_[0];
+    double hi = autoRange_ ? S->max : range_[1];
+    if (!(hi > lo))
+    {
+        // all values equal
+        lo -= 0.5;
+        hi += 0.5;
+    }
+
+    // rebin the cached fine histogram
+    std::vector<double> h = S->histogram(nbins_, lo, hi);
+
+    // bin edges & counts, the last count is repeated to close the last step
+    std::vector<double> x(nbins_ + 1), y(nbins_ + 1);
+    const double dx = (hi - lo) / nbins_;
+    for (int k = 0; k <= nbins_; ++k)
+    {
+        x[k] = lo + k * dx;
+        y[k] = h[std::min(k, nbins_ - 1)];
+    }
+    histPlot->stairs(x, y);
+
+    histPlot->setXlabel(slice_->description().empty() ? "Value" : slice_->description().c_str());
+    histPlot->setYlabel("Counts");
+    histPlot->setTitle(source_ == DatasetValues ? "Dataset histogram" : "Slice histogram");
+}
+
+void QHistogramDataView::createOptionsMenu()
+{
+    optionsMenu_ = new QMenu((QWidget *)this);
+
+    QMenu *m;
+    QAction *a;
+
+    m = optionsMenu_->addMenu("Values");
+    sourceGroup = new QActionGroup(this);
+    a = m->addAction("Current slice", this, [this]() { setSource(SliceValues); });
+    a->setCheckable(true);
+    a->setChecked(source_ == SliceValues);
+    sourceGroup->addAction(a);
+    a = m->addAction("Whole dataset", this, [this]() { setSource(DatasetValues); });
+    a->setCheckable(true);
+    a->setChecked(source_ == DatasetValues);
+    sourceGroup->addAction(a);
+
+    m = optionsMenu_->addMenu("Bins");
+    binsGroup = new QActionGroup(this);
+    for (int n : {16, 32, 64, 128, 256, 512, 1024})
+    {
+        a = m->addAction(QString::number(n), this, [this, n]() { setBinCount(n); });
+        a->setCheckable(true);
+        a->setChecked(nbins_ == n);
+        a->setData(n);
+        binsGroup->addAction(a);
+    }
+
+    m = optionsMenu_->addMenu("Range");
+    autoRangeAct = m->addAction("Auto (min - max)", this, SLOT(setAutoRange(bool)));
+    autoRangeAct->setCheckable(true);
+    autoRangeAct->setChecked(autoRange_);
+    m->addAction("Set range ...", this, SLOT(onSetRange()));
+
+    optionsMenu_->addSeparator();
+
+    gridAct = optionsMenu_->addAction("Grid", histPlot, SLOT(setGrid(bool)));
+    gridAct->setCheckable(true);
+    gridAct->setChecked(histPlot->grid());
+}
+
+void QHistogramDataView::updateOptionsMenu()
+{
+    sourceGroup->actions().at(0)->setChecked(source_ == SliceValues);
+    sourceGroup->actions().at(1)->setChecked(source_ == DatasetValues);
+    sourceGroup->actions().at(1)->setEnabled(datasetStats_ != nullptr);
+    for (QAction *a : binsGroup->actions())
+        a->setChecked(a->data().toInt() == nbins_);
+    autoRangeAct->setChecked(autoRange_);
+    gridAct->setChecked(histPlot->grid());
+}
+
+void QHistogramDataView::onSetRange()
+{
+    const DataStats *S = stats_();
+    double lo = autoRange_ && S ? S->min : range_[0];
+    double hi = autoRange_ && S ? S->max : range_[1];
+
+    bool ok;
+    lo = QInputDialog::getDouble(this, "Histogram range", "Min", lo, -1e300, 1e300, 6, &ok);
+    if (!ok)
+        return;
+    hi = QInputDialog::getDouble(this, "Histogram range", "Max", std::max(hi, lo), lo, 1e300, 6, &ok);
+    if (!ok)
+        return;
+    setRange(lo, hi);
+}
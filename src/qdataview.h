@@ -3,8 +3,13 @@
 
 //#include <QWidget>
 
+#include "colormap.h"
+#include "frameplayer.h"
+#include "linedecimator.h"
 #include "qdatabrowser.h"
 
+#include <memory>
+
 class QTableView;
 class QLabel;
 class QMenu;
@@ -13,8 +18,10 @@ class QStackedWidget;
 class QPlainTextEdit;
 
 class DataSlice;
+struct DataStats;
 class QDataTableModel;
 class QMatPlotWidget;
+class QHeatMapWidget;
 
 class QAbstractDataView : public QWidget
 {
@@ -28,6 +35,11 @@ public:
     virtual bool canExportImage() const { return false; }
     virtual void exportImage() const {}
     virtual QMenu *optionsMenu() { return nullptr; }
+    // work done on playback frames in the player threads, before they
+    // are shown, e.g. color mapping
+    virtual FramePlayer::prepare_t framePreparer() const { return FramePlayer::prepare_t(); }
+    // global stats of the dataset, nullptr if not available
+    virtual void setDatasetStats(const DataStats *) {}
 
 signals:
     void viewUpdated();
@@ -35,6 +47,8 @@ signals:
 public slots:
     virtual void setData(DataSlice *s);
     void updateView();
+    // a playback frame is in the slice, by default the view is updated
+    virtual void showFrame(FramePlayer::FramePtr f);
 
 protected:
     // data slice
@@ -85,6 +99,8 @@ protected:
     // view widgets
     QMatPlotWidget *linePlot;
     QDataBrowser::PlotType type_{QDataBrowser::Line};
+    // min/max decimated line, extended when the data grows
+    LineDecimator decimator_;
 
     // Options menu & actions
     QMenu *optionsMenu_;
@@ -94,12 +110,58 @@ protected:
     QActionGroup *plotTypeGroup;
 
     virtual void updateView_() override;
+    void plotDecimated_();
     void createOptionsMenu();
+    // plot types available for the current slice
+    virtual bool supportsPlotType(QDataBrowser::PlotType t) const;
 
 protected slots:
     void updateOptionsMenu();
 };
 
+// Multi-trace line plot of a 2D slice
+//
+// Each row of the slice (the values along x at one y index) is a trace.
+// All traces, or every k-th one up to a max count, are overlaid or
+// offset vertically (waterfall). Traces are min/max decimated separately,
+// sharing a budget of plotted points, and drawn in one batch as a single
+// line broken by NaN. After a partial data update only the changed
+// traces are decimated again.
+class QTracesDataView : public QPlotDataView
+{
+    Q_OBJECT
+public:
+    explicit QTracesDataView(QWidget *parent = nullptr);
+
+    QIcon icon() const override;
+
+    bool offset() const { return offset_; }
+    // max number of traces, 0 for all
+    int maxTraces() const { return maxTraces_; }
+
+public slots:
+    void setOffset(bool on);
+    void setMaxTraces(int n);
+
+protected:
+    bool offset_{false};
+    int maxTraces_{64};
+
+    // decimated traces & the slice rows they show
+    std::vector<LineDecimator> traces_;
+    std::vector<size_t> traceRows_;
+
+    QActionGroup *offsetGroup;
+    QActionGroup *maxTracesGroup;
+
+    virtual void updateView_() override;
+    bool supportsPlotType(QDataBrowser::PlotType t) const override;
+    void decimate_(const std::vector<size_t> &idx);
+
+protected slots:
+    void updateTracesMenu();
+};
+
 class QHeatMapDataView : public QAbstractDataView
 {
     Q_OBJECT
@@ -114,22 +176,106 @@ public:
     bool canExportImage() const override { return true; }
     void exportImage() const override;
 
+    // source of the color limits
+    enum Limits { SliceLimits, DatasetLimits, FixedLimits };
+
+    Limits limitsMode() const { return limits_; }
+
+    FramePlayer::prepare_t framePreparer() const override;
+
+public slots:
+    void showFrame(FramePlayer::FramePtr f) override;
+    void setColorMap(ColorMap::Palette p);
+    void setColorScale(ColorMap::Scale s);
+    void setLimitsMode(QHeatMapDataView::Limits l);
+    void setFixedLimits(double lo, double hi);
+    void setDatasetStats(const DataStats *s) override;
+
 protected:
     // view widgets
-    QMatPlotWidget *heatMap;
-    int cmap_;
+    QHeatMapWidget *heatMap;
+
+    Limits limits_{SliceLimits};
+    double fixed_[2]{0., 1.};
+    // dataset range, for the log scale the min of the positive values
+    bool hasDatasetRange_{false};
+    double dataset_[2]{0., 1.}, datasetPos_[2]{0., 1.};
 
     // Options menu & actions
     QMenu *optionsMenu_;
     QAction *gridAct;
     QActionGroup *linLogGroup;
     QActionGroup *colormapGroup;
+    QActionGroup *limitsGroup;
+
+    virtual void updateView_() override;
+    void applyLimits();
+    void createOptionsMenu();
+
+protected slots:
+    void updateOptionsMenu();
+    void onSetLimits();
+};
+
+class QHistogramDataView : public QAbstractDataView
+{
+    Q_OBJECT
+public:
+    explicit QHistogramDataView(QWidget *parent = nullptr);
+    ~QHistogramDataView();
+
+    QWidget *view() override { return (QWidget *)histPlot; }
+    QIcon icon() const override;
+
+    QMenu *optionsMenu() override { return optionsMenu_; }
+
+    bool canExportImage() const override { return true; }
+    void exportImage() const override;
+
+    // values to bin: the current slice or the whole dataset
+    enum Source { SliceValues, DatasetValues };
+
+    Source source() const { return source_; }
+    int binCount() const { return nbins_; }
+    // true if the range is the min/max of the values
+    bool autoRange() const { return autoRange_; }
+
+public slots:
+    void setSource(QHistogramDataView::Source s);
+    void setBinCount(int n);
+    void setRange(double lo, double hi);
+    void setAutoRange(bool on = true);
+    void setDatasetStats(const DataStats *s) override;
+
+protected:
+    // view widgets
+    QMatPlotWidget *histPlot;
+
+    Source source_{SliceValues};
+    int nbins_{64};
+    bool autoRange_{true};
+    double range_[2]{0., 1.};
+
+    // fine histograms, rebinned when the bins or range change
+    // the slice one is computed when the slice values are shown
+    std::unique_ptr<DataStats> sliceStats_, datasetStats_;
+
+    // Options menu & actions
+    QMenu *optionsMenu_;
+    QActionGroup *sourceGroup;
+    QActionGroup *binsGroup;
+    QAction *autoRangeAct;
+    QAction *gridAct;
 
     virtual void updateView_() override;
+    void replot();
     void createOptionsMenu();
+    // the stats of the shown values, nullptr if there are none
+    const DataStats *stats_();
 
 protected slots:
     void updateOptionsMenu();
+    void onSetRange();
 };
 
 #endif // QABSTRACTDATAVIEW_H
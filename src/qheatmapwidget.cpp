@@ -0,0 +1,381 @@
+#include "qheatmapwidget.h"
+
+#include "datareduction.h"
+
+#include <QFileInfo>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// below this number of pixels the mapping runs in the calling thread
+const size_t min_parallel_size = 1 << 18;
+
+// about n "nice" (1, 2, 5 x 10^k) tick values in [a, b]
+QVector<double> niceTicks(double a, double b, int n)
+{
+    QVector<double> t;
+    if (!(b > a) || n < 1 || !std::isfinite(b - a))
+        return t;
+    double raw = (b - a) / n;
+    double p = std::pow(10., std::floor(std::log10(raw)));
+    double f = raw / p;
+    double step = (f < 1.5 ? 1. : (f < 3.5 ? 2. : (f < 7.5 ? 5. : 10.))) * p;
+    for (double k = std::ceil(a / step); k * step <= b * (1 + 1e-12); k += 1.)
+        t.push_back(std::abs(k) < 1e-9 ? 0. : k * step);
+    return t;
+}
+
+} // namespace
+
+QHeatMapWidget::QHeatMapWidget(QWidget *parent)
+    : QWidget{parent}
+{
+    setMinimumSize(200, 150);
+}
+
+void QHeatMapWidget::setData(int nx, int ny)
+{
+    nx_ = nx;
+    ny_ = ny;
+    if (img_.width() != nx || img_.height() != ny)
+        img_ = QImage(nx, ny, QImage::Format_RGB32);
+    remap();
+}
+
+void QHeatMapWidget::updateRows(const std::vector<std::pair<size_t, size_t>> &rows)
+{
+    const double *v = data();
+    if (!v || img_.isNull() || rows.empty())
+        return;
+
+    if (autoLimits_)
+    {
+        // a changed row may have held the min or max, so the range needs
+        // a full pass; it is much cheaper than recoloring everything
+        double lo, hi;
+        if (ColorMap::range(v, size_t(nx_) * ny_, cmap_.scale(), lo, hi)
+            && (lo != cmap_.lo() || hi != cmap_.hi()))
+        {
+            cmap_.setLimits(lo, hi);
+            mapRows(v, 0, ny_);
+            update();
+            return;
+        }
+    }
+
+    bool yflip = yr_[1] < yr_[0];
+    const QRect &P = plotRect_;
+    for (const auto &r : rows)
+    {
+        int j0 = int(r.first), j1 = std::min(int(r.second), ny_);
+        mapRows(v, j0, j1);
+        if (P.isEmpty())
+            continue;
+        // image lines covered by the rows, then their widget area
+        int l0 = yflip ? j0 : ny_ - j1, l1 = yflip ? j1 : ny_ - j0;
+        int y0 = P.top() + int(double(l0) * P.height() / ny_);
+        int y1 = P.top() + int(std::ceil(double(l1) * P.height() / ny_));
+        update(QRect(P.left(), y0 - 1, P.width() + 1, y1 - y0 + 2));
+    }
+    if (P.isEmpty())
+        update();
+}
+
+void QHeatMapWidget::setMappedData(int nx, int ny, const QImage &img, double lo, double hi)
+{
+    if (img.width() != nx || img.height() != ny)
+    {
+        setData(nx, ny);
+        return;
+    }
+    nx_ = nx;
+    ny_ = ny;
+    img_ = img;
+    cmap_.setLimits(lo, hi);
+    update();
+}
+
+QImage QHeatMapWidget::mapImage(const ColorMap &c, const double *v, int nx, int ny)
+{
+    QImage img(nx, ny, QImage::Format_RGB32);
+    // data row j is image line ny - 1 - j (y upwards)
+    for (int j = 0; j < ny; ++j)
+        c.map(v + size_t(j) * nx, nx, (QRgb *)img.scanLine(ny - 1 - j));
+    return img;
+}
+
+void QHeatMapWidget::setXRange(double x0, double x1)
+{
+    xr_[0] = x0;
+    xr_[1] = x1;
+    update();
+}
+
+void QHeatMapWidget::setYRange(double y0, double y1)
+{
+    yr_[0] = y0;
+    yr_[1] = y1;
+    update();
+}
+
+void QHeatMapWidget::clear()
+{
+    nx_ = ny_ = 0;
+    img_ = QImage();
+    update();
+}
+
+void QHeatMapWidget::setColorMap(ColorMap::Palette p)
+{
+    cmap_.setPalette(p);
+    remap();
+}
+
+void QHeatMapWidget::setColorScale(ColorMap::Scale s)
+{
+    cmap_.setScale(s);
+    remap();
+}
+
+void QHeatMapWidget::setAutoLimits(bool on)
+{
+    autoLimits_ = on;
+    remap();
+}
+
+void QHeatMapWidget::setLimits(double lo, double hi)
+{
+    autoLimits_ = false;
+    cmap_.setLimits(lo, hi);
+    remap();
+}
+
+void QHeatMapWidget::setXlabel(const QString &s)
+{
+    xlabel_ = s;
+    update();
+}
+
+void QHeatMapWidget::setYlabel(const QString &s)
+{
+    ylabel_ = s;
+    update();
+}
+
+void QHeatMapWidget::setTitle(const QString &s)
+{
+    title_ = s;
+    update();
+}
+
+void QHeatMapWidget::setGrid(bool on)
+{
+    grid_ = on;
+    update();
+}
+
+void QHeatMapWidget::remap()
+{
+    const double *v = nx_ > 0 && ny_ > 0 ? data() : nullptr;
+    if (v)
+    {
+        if (autoLimits_)
+        {
+            // the only full pass over the data besides the mapping
+            double lo, hi;
+            if (ColorMap::range(v, size_t(nx_) * ny_, cmap_.scale(), lo, hi))
+                cmap_.setLimits(lo, hi);
+        }
+        mapRows(v, 0, ny_);
+    }
+    update();
+}
+
+void QHeatMapWidget::mapRows(const double *v, int j0, int j1)
+{
+    if (!v || j1 <= j0)
+        return;
+
+    // data row j is image line ny - 1 - j (y upwards)
+    auto work = [this, v](int r0, int r1) {
+        for (int j = r0; j < r1; ++j)
+            cmap_.map(v + size_t(j) * nx_, nx_, (QRgb *)img_.scanLine(ny_ - 1 - j));
+    };
+
+    size_t nthreads = std::min(size_t(DataReduction::maxThreads()), size_t(j1 - j0));
+    if (size_t(j1 - j0) * nx_ < min_parallel_size)
+        nthreads = 1;
+    if (nthreads == 1)
+    {
+        work(j0, j1);
+        return;
+    }
+
+    // scanLine() may detach the image, do it before starting the threads
+    img_.bits();
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; ++t)
+        threads.emplace_back(work, j0 + int((j1 - j0) * t / nthreads), j0 + int((j1 - j0) * (t + 1) / nthreads));
+    for (std::thread &th : threads)
+        th.join();
+}
+
+bool QHeatMapWidget::exportToFile(const QString &fname, const QSize &sz) const
+{
+    if (QFileInfo(fname).suffix().toLower() == "pdf")
+    {
+        QPdfWriter w(fname);
+        w.setPageSize(QPageSize(QSizeF(sz), QPageSize::Millimeter));
+        w.setPageMargins(QMarginsF(0, 0, 0, 0));
+        QPainter p(&w);
+        render(p, QRect(0, 0, w.width(), w.height()));
+        return true;
+    }
+    QImage im(sz, QImage::Format_RGB32);
+    im.fill(Qt::white);
+    QPainter p(&im);
+    render(p, im.rect());
+    p.end();
+    return im.save(fname);
+}
+
+void QHeatMapWidget::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.fillRect(rect(), palette().color(QPalette::Base));
+    plotRect_ = render(p, rect());
+}
+
+QRect QHeatMapWidget::render(QPainter &p, const QRect &r) const
+{
+    const QFontMetrics fm(p.font(), p.device());
+    const int h = fm.height();
+    const int tick = h / 3;
+
+    if (img_.isNull())
+        return QRect();
+
+    // axis extents: the pixels are centered on the coordinates
+    auto extent = [](const double *c, int n, double &a, double &b) {
+        double d = n > 1 ? (c[1] - c[0]) / (n - 1) : 1.;
+        a = c[0] - d / 2;
+        b = c[1] + d / 2;
+        if (a > b)
+            std::swap(a, b);
+    };
+    double xa, xb, ya, yb;
+    extent(xr_, nx_, xa, xb);
+    extent(yr_, ny_, ya, yb);
+    bool xflip = xr_[1] < xr_[0], yflip = yr_[1] < yr_[0];
+
+    // color scale ticks, in transformed units
+    double ua = cmap_.transform(cmap_.lo()), ub = cmap_.transform(cmap_.hi());
+    QStringList clbls;
+    QVector<double> cticks = niceTicks(ua, ub, 6);
+    int cw = 0;
+    for (double u : cticks)
+    {
+        clbls << QString::number(cmap_.inverse(u), 'g', 3);
+        cw = std::max(cw, fm.horizontalAdvance(clbls.back()));
+    }
+
+    QVector<double> yticks = niceTicks(ya, yb, 6);
+    int yw = 0;
+    for (double y : yticks)
+        yw = std::max(yw, fm.horizontalAdvance(QString::number(y, 'g', 4)));
+
+    // plot & colorbar rectangles
+    int left = r.left() + h / 2 + (ylabel_.isEmpty() ? 0 : h + h / 2) + yw + tick;
+    int top = r.top() + (title_.isEmpty() ? h / 2 : 2 * h);
+    int bottom = r.bottom() - h / 2 - (xlabel_.isEmpty() ? 0 : h + h / 2) - h - tick;
+    int cbw = h;
+    int right = r.right() - h / 2 - cw - tick - cbw - h;
+    if (right - left < 10 || bottom - top < 10)
+        return QRect();
+    QRect P(QPoint(left, top), QPoint(right, bottom));
+    QRect C(QPoint(right + h, top), QPoint(right + h + cbw, bottom));
+
+    // image, flipped if the coordinates decrease
+    QImage img = (xflip || yflip) ? img_.mirrored(xflip, yflip) : img_;
+    p.drawImage(P, img);
+
+    // colorbar
+    QImage bar(1, 256, QImage::Format_RGB32);
+    for (int i = 0; i < 256; ++i)
+        bar.setPixel(0, 255 - i, cmap_.color(i / 255.));
+    p.drawImage(C, bar);
+
+    p.setPen(palette().color(QPalette::WindowText));
+    p.setBrush(Qt::NoBrush);
+    p.drawRect(P);
+    p.drawRect(C);
+
+    // x axis
+    for (double x : niceTicks(xa, xb, std::max(2, P.width() / (8 * h))))
+    {
+        int px = P.left() + int((x - xa) / (xb - xa) * P.width());
+        p.drawLine(px, P.bottom(), px, P.bottom() + tick);
+        if (grid_ && px > P.left() && px < P.right())
+        {
+            p.save();
+            p.setPen(QPen(palette().color(QPalette::Mid), 0, Qt::DotLine));
+            p.drawLine(px, P.top(), px, P.bottom());
+            p.restore();
+        }
+        QString s = QString::number(x, 'g', 4);
+        p.drawText(QRect(px - 50 * h, P.bottom() + tick, 100 * h, h), Qt::AlignHCenter | Qt::AlignTop, s);
+    }
+    if (!xlabel_.isEmpty())
+        p.drawText(QRect(P.left(), P.bottom() + tick + h + h / 2, P.width(), h),
+                   Qt::AlignHCenter | Qt::AlignTop,
+                   xlabel_);
+
+    // y axis
+    for (double y : yticks)
+    {
+        int py = P.bottom() - int((y - ya) / (yb - ya) * P.height());
+        p.drawLine(P.left() - tick, py, P.left(), py);
+        if (grid_ && py > P.top() && py < P.bottom())
+        {
+            p.save();
+            p.setPen(QPen(palette().color(QPalette::Mid), 0, Qt::DotLine));
+            p.drawLine(P.left(), py, P.right(), py);
+            p.restore();
+        }
+        QString s = QString::number(y, 'g', 4);
+        p.drawText(QRect(P.left() - tick - yw - 2, py - h / 2, yw, h), Qt::AlignRight | Qt::AlignVCenter, s);
+    }
+    if (!ylabel_.isEmpty())
+    {
+        p.save();
+        p.translate(r.left() + h / 2, P.center().y());
+        p.rotate(-90);
+        p.drawText(QRect(-P.height() / 2, 0, P.height(), h), Qt::AlignHCenter | Qt::AlignTop, ylabel_);
+        p.restore();
+    }
+
+    // colorbar ticks
+    for (int k = 0; k < cticks.size(); ++k)
+    {
+        int py = C.bottom() - int((cticks[k] - ua) / (ub - ua) * C.height());
+        p.drawLine(C.right(), py, C.right() + tick, py);
+        p.drawText(QRect(C.right() + tick + 2, py - h / 2, cw, h), Qt::AlignLeft | Qt::AlignVCenter, clbls[k]);
+    }
+
+    if (!title_.isEmpty())
+    {
+        QFont f = p.font();
+        f.setBold(true);
+        p.save();
+        p.setFont(f);
+        p.drawText(QRect(r.left(), r.top() + h / 2, r.width(), h), Qt::AlignHCenter | Qt::AlignTop, title_);
+        p.restore();
+    }
+    return P;
+}
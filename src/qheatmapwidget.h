@@ -0,0 +1,101 @@
+#ifndef QHEATMAPWIDGET_H
+#define QHEATMAPWIDGET_H
+
+#include "colormap.h"
+
+#include <QImage>
+#include <QWidget>
+
+#include <functional>
+
+// A heat map of 2D data with axes & colorbar
+//
+// The data is mapped to colors once, into a QImage with one pixel per
+// data point, which is then scaled to the widget on paint.
+// Changing the color map, scale or limits remaps the data.
+// Partial data changes recolor and repaint only the changed rows.
+//
+// The widget holds no pointer to the data: the owner's buffer may be
+// reallocated at any time (e.g. released to meet a memory budget), so
+// the data are obtained from the source function on every remap.
+class QHeatMapWidget : public QWidget
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool grid READ grid WRITE setGrid)
+
+public:
+    explicit QHeatMapWidget(QWidget *parent = nullptr);
+
+    // returns the current nx x ny values in column-major order (x fastest),
+    // or nullptr if there are none or they do not match the shape
+    typedef std::function<const double *()> source_t;
+    void setSource(const source_t &f) { source_ = f; }
+    // the data shape, all values have changed
+    void setData(int nx, int ny);
+    // the values of some data rows have changed, as [j0, j1) ranges
+    // only these rows are recolored & repainted unless, with auto
+    // limits, the data range changed too
+    void updateRows(const std::vector<std::pair<size_t, size_t>> &rows);
+    // set the data image, mapped elsewhere with a copy of colorMap()
+    // (e.g. by mapImage in a worker thread) using limits lo, hi
+    void setMappedData(int nx, int ny, const QImage &img, double lo, double hi);
+    // the image of nx x ny data values, in the calling thread
+    static QImage mapImage(const ColorMap &c, const double *v, int nx, int ny);
+    // data coordinates of the 1st & last pixel centers
+    void setXRange(double x0, double x1);
+    void setYRange(double y0, double y1);
+    void clear();
+
+    const double *data() const { return source_ ? source_() : nullptr; }
+    int nx() const { return nx_; }
+    int ny() const { return ny_; }
+
+    const ColorMap &colorMap() const { return cmap_; }
+    void setColorMap(ColorMap::Palette p);
+    void setColorScale(ColorMap::Scale s);
+
+    // color limits; in auto mode they are the range of the data
+    bool autoLimits() const { return autoLimits_; }
+    void setAutoLimits(bool on = true);
+    void setLimits(double lo, double hi);
+
+    void setXlabel(const QString &s);
+    void setYlabel(const QString &s);
+    void setTitle(const QString &s);
+
+    bool grid() const { return grid_; }
+
+    const QImage &image() const { return img_; }
+
+    // export to pdf, or image file according to the suffix
+    // size in mm (pdf) or pixels
+    bool exportToFile(const QString &fname, const QSize &sz) const;
+
+public slots:
+    void setGrid(bool on);
+
+protected:
+    void paintEvent(QPaintEvent *e) override;
+
+    // draw in r, return the rectangle of the image
+    QRect render(QPainter &p, const QRect &r) const;
+
+    // map rows [j0, j1) of the data v to the image
+    void mapRows(const double *v, int j0, int j1);
+    void remap();
+
+private:
+    source_t source_;
+    int nx_{0}, ny_{0};
+    double xr_[2]{0., 1.}, yr_[2]{0., 1.};
+    ColorMap cmap_;
+    bool autoLimits_{true};
+    QImage img_;
+    QRect plotRect_; // image area in the last paint
+
+    QString xlabel_, ylabel_, title_;
+    bool grid_{false};
+};
+
+#endif // QHEATMAPWIDGET_H
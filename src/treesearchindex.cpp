@@ -0,0 +1,231 @@
+#include "treesearchindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+std::string lower(const QString &s)
+{
+    return s.toLower().toUtf8().toStdString();
+}
+
+uint32_t trigram(const char *p)
+{
+    return uint32_t(uint8_t(p[0])) | uint32_t(uint8_t(p[1])) << 8 | uint32_t(uint8_t(p[2])) << 16;
+}
+
+} // namespace
+
+TreeSearchIndex::id_t TreeSearchIndex::add(id_t parent, const QString &name, const QString &desc)
+{
+    id_t id = id_t(entries_.size());
+    entries_.push_back({parent, true, lower(name), lower(desc)});
+    index_(id, entries_.back().name);
+    index_(id, entries_.back().desc);
+    lastComplete_ = false;
+    return id;
+}
+
+void TreeSearchIndex::describe(id_t id, const QString &desc)
+{
+    if (id >= entries_.size() || !entries_[id].alive)
+        return;
+    // trigrams of the old description stay in the lists,
+    // such candidates fail the verification
+    entries_[id].desc = lower(desc);
+    index_(id, entries_[id].desc);
+    lastComplete_ = false;
+}
+
+void TreeSearchIndex::remove(id_t id)
+{
+    if (id >= entries_.size() || !entries_[id].alive)
+        return;
+    entry &e = entries_[id];
+    e.alive = false;
+    std::string().swap(e.name);
+    std::string().swap(e.desc);
+    ++dead_;
+    lastComplete_ = false;
+    if (dead_ > 1024 && 2 * dead_ > entries_.size())
+        compact_();
+}
+
+void TreeSearchIndex::clear()
+{
+    entries_.clear();
+    postings_.clear();
+    dead_ = 0;
+    lastQuery_.clear();
+    lastMatches_.clear();
+    lastComplete_ = false;
+}
+
+// add id to the lists of the trigrams of s, keeping them sorted
+// new nodes are appended, only describe() inserts earlier ids
+void TreeSearchIndex::index_(id_t id, const std::string &s)
+{
+    for (size_t i = 0; i + 3 <= s.size(); ++i)
+    {
+        std::vector<id_t> &l = postings_[trigram(s.data() + i)];
+        if (l.empty() || l.back() < id)
+            l.push_back(id);
+        else
+        {
+            auto it = std::lower_bound(l.begin(), l.end(), id);
+            if (*it != id)
+                l.insert(it, id);
+        }
+    }
+}
+
+// drop the removed nodes, renumber the others in order & rebuild the lists
+// a parent removed before its children leaves them at the top level
+void TreeSearchIndex::compact_()
+{
+    std::vector<id_t> newId(entries_.size(), npos);
+    std::vector<entry> live;
+    live.reserve(entries_.size() - dead_);
+    for (id_t id = 0; id < entries_.size(); ++id)
+        if (entries_[id].alive)
+        {
+            newId[id] = id_t(live.size());
+            live.push_back(std::move(entries_[id]));
+            if (live.back().parent != npos)
+                live.back().parent = newId[live.back().parent];
+        }
+    entries_.swap(live);
+    dead_ = 0;
+
+    decltype(postings_)().swap(postings_);
+    for (id_t id = 0; id < entries_.size(); ++id)
+    {
+        index_(id, entries_[id].name);
+        index_(id, entries_[id].desc);
+    }
+    lastMatches_.clear();
+    lastComplete_ = false;
+
+    if (compacted)
+        compacted(newId);
+}
+
+void TreeSearchIndex::path_(id_t id, std::string &buf) const
+{
+    const entry &e = entries_[id];
+    if (e.parent != npos)
+        path_(e.parent, buf);
+    buf += '/';
+    buf += e.name;
+}
+
+bool TreeSearchIndex::matches_(id_t id, const std::string &q, bool inPath, std::string &buf) const
+{
+    const entry &e = entries_[id];
+    if (!e.alive)
+        return false;
+    if (e.name.find(q) != std::string::npos || e.desc.find(q) != std::string::npos)
+        return true;
+    if (!inPath)
+        return false;
+    buf.clear();
+    path_(id, buf);
+    return buf.find(q) != std::string::npos;
+}
+
+bool TreeSearchIndex::find(const QString &query, size_t max, std::vector<id_t> &ids)
+{
+    ids.clear();
+    std::string q = lower(query);
+    if (q.empty())
+        return true;
+
+    const bool inPath = q.find('/') != std::string::npos;
+    std::vector<id_t> matches;
+    bool complete = true;
+    std::string buf;
+
+    if (lastComplete_ && q.find(lastQuery_) != std::string::npos
+        && inPath == (lastQuery_.find('/') != std::string::npos))
+    {
+        // the matches of q are a subset of the last matches
+        for (id_t id : lastMatches_)
+            if (matches_(id, q, inPath, buf))
+                matches.push_back(id);
+    }
+    else if (inPath || q.size() < 3)
+    {
+        // scan, short queries stop once it is known that there are more than max
+        for (id_t id = 0; id < entries_.size(); ++id)
+            if (matches_(id, q, inPath, buf))
+            {
+                matches.push_back(id);
+                if (!inPath && matches.size() > max)
+                {
+                    complete = false;
+                    break;
+                }
+            }
+    }
+    else
+    {
+        // intersect the posting lists, shortest first
+        std::vector<const std::vector<id_t> *> lists;
+        for (size_t i = 0; i + 3 <= q.size(); ++i)
+        {
+            auto it = postings_.find(trigram(q.data() + i));
+            if (it == postings_.end())
+            {
+                lists.clear();
+                break;
+            }
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const std::vector<id_t> *a, const std::vector<id_t> *b) {
+            return a->size() < b->size();
+        });
+        lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+        std::vector<id_t> c, tmp;
+        if (!lists.empty())
+            c = *lists[0];
+        for (size_t k = 1; k < lists.size() && !c.empty(); ++k)
+        {
+            tmp.clear();
+            std::set_intersection(c.begin(), c.end(), lists[k]->begin(), lists[k]->end(), std::back_inserter(tmp));
+            c.swap(tmp);
+        }
+        for (id_t id : c)
+            if (matches_(id, q, false, buf))
+                matches.push_back(id);
+    }
+
+    lastQuery_ = q;
+    lastComplete_ = complete;
+    if (complete)
+        lastMatches_ = matches;
+    else
+        lastMatches_.clear();
+
+    ids.assign(matches.begin(), matches.begin() + std::min(max, matches.size()));
+    return matches.size() <= max;
+}
+
+size_t TreeSearchIndex::memory_usage() const
+{
+    size_t n = sizeof(*this) + entries_.capacity() * sizeof(entry);
+    for (const entry &e : entries_)
+    {
+        // beyond the small string buffer
+        if (e.name.capacity() > 15)
+            n += e.name.capacity() + 1;
+        if (e.desc.capacity() > 15)
+            n += e.desc.capacity() + 1;
+    }
+    for (const auto &p : postings_)
+        n += sizeof(p) + 2 * sizeof(void *) + p.second.capacity() * sizeof(id_t);
+    n += postings_.bucket_count() * sizeof(void *);
+    n += lastMatches_.capacity() * sizeof(id_t);
+    return n;
+}
@@ -0,0 +1,80 @@
+#ifndef TREESEARCHINDEX_H
+#define TREESEARCHINDEX_H
+
+#include <QString>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Case-insensitive substring search over the nodes of a data tree
+//
+// Each node has a name, an optional description and a parent, so that its
+// path is /parent path/name. A node matches a query contained in its name
+// or description, or, if the query has a '/', in its path.
+//
+// Candidates come from a trigram index: the posting list of every 3-byte
+// sequence (of the lowercase UTF-8 text) holds the ids of the nodes whose
+// name or description contains it. The lists of the query trigrams are
+// intersected and the candidates verified. Shorter queries scan the nodes.
+// Path components are not indexed: a path query is a linear scan that
+// builds the path of every node, O(nodes x depth). A query extending the
+// previous one filters its matches, so typing a filter narrows the results
+// incrementally.
+//
+// Ids increase with insertion, so posting lists are sorted by appending.
+// Removed nodes are only flagged; when more than half of the nodes are dead
+// the live ones are renumbered (keeping their order) and the lists rebuilt,
+// the new ids are passed to compacted.
+class TreeSearchIndex
+{
+public:
+    typedef uint32_t id_t;
+    static const id_t npos = id_t(-1);
+
+    // add a node below parent (npos for top level nodes), return its id
+    id_t add(id_t parent, const QString &name, const QString &desc = QString());
+    // set the description of a node
+    void describe(id_t id, const QString &desc);
+    // remove a node, its children must be removed separately
+    void remove(id_t id);
+    void clear();
+
+    // number of nodes
+    size_t size() const { return entries_.size() - dead_; }
+
+    // ids of the nodes matching query, at most max, in insertion order
+    // return false if there are more matches
+    bool find(const QString &query, size_t max, std::vector<id_t> &ids);
+
+    size_t memory_usage() const;
+
+    // called when removed nodes are dropped, with the new id of each old id
+    // (npos for the removed ones)
+    std::function<void(const std::vector<id_t> &)> compacted;
+
+private:
+    struct entry
+    {
+        id_t parent;
+        bool alive;
+        std::string name, desc; // lowercase UTF-8
+    };
+    std::vector<entry> entries_;
+    std::unordered_map<uint32_t, std::vector<id_t>> postings_;
+    size_t dead_{0};
+
+    // the last query & all of its matches, for narrowing
+    std::string lastQuery_;
+    std::vector<id_t> lastMatches_;
+    bool lastComplete_{false};
+
+    void index_(id_t id, const std::string &s);
+    void compact_();
+    bool matches_(id_t id, const std::string &q, bool inPath, std::string &buf) const;
+    void path_(id_t id, std::string &buf) const;
+};
+
+#endif // TREESEARCHINDEX_H
@@ -0,0 +1,155 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include "dataslice.h"
+#include "syntheticstore.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+// Fixtures shared by the tests. The values of a SyntheticDataStore are
+// known by index, so the optimized paths are compared with direct reads.
+
+// maps slice-store indexes to the indexes of the original store
+typedef std::function<AbstractDataStore::dim_t(const AbstractDataStore::dim_t &)> index_map_t;
+
+inline SyntheticDataStore &synthetic(const DataStorePtr &D)
+{
+    return *static_cast<SyntheticDataStore *>(D.data());
+}
+
+inline bool nearlyEqual(double a, double b, double tol = 1e-5)
+{
+    return std::abs(a - b) <= tol * std::max(1.0, std::abs(b));
+}
+
+inline QString dimStr(const AbstractDataStore::dim_t &i)
+{
+    QStringList l;
+    for (size_t k : i)
+        l << QString::number(k);
+    return QString("(%1)").arg(l.join(','));
+}
+
+inline AbstractDataStore::dim_t identity(const AbstractDataStore::dim_t &i)
+{
+    return i;
+}
+
+// compare a slice element-by-element to the synthetic store
+inline bool compareSlice(const DataSlice &s,
+                         const SyntheticDataStore &S,
+                         const index_map_t &map,
+                         QString &msg)
+{
+    AbstractDataStore::dim_t i(s.i0());
+    size_t nx = s.dim()[0];
+    size_t ny = s.ndim() > 1 ? s.dim()[1] : 1;
+    for (size_t jy = 0; jy < ny; ++jy)
+    {
+        for (size_t jx = 0; jx < nx; ++jx)
+        {
+            i[s.dx()] = jx;
+            if (s.ndim() > 1)
+                i[s.dy()] = jy;
+            size_t k = S.idx(map(i));
+            if (S.is_numeric())
+            {
+                if (s(jx, jy) != SyntheticDataStore::value(k))
+                {
+                    msg = QString("data mismatch at %1").arg(dimStr(i));
+                    return false;
+                }
+                if (S.hasErrors() && s.errors()[jx + jy * nx] != SyntheticDataStore::error(k))
+                {
+                    msg = QString("error mismatch at %1").arg(dimStr(i));
+                    return false;
+                }
+            }
+            else if (s.text_data(jx, jy) != SyntheticDataStore::text(k))
+            {
+                msg = QString("text mismatch at %1").arg(dimStr(i));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// a level of nested reductions: op over [k0, k1) of dim d
+struct ReductionLevel
+{
+    size_t d;
+    DataReduction::op_t op;
+    size_t k0, k1;
+};
+
+// direct computation of nested reductions of the store at index i,
+// levels[0] is the outermost; Std is the population deviation
+inline double reduce(const SyntheticDataStore &S,
+                     AbstractDataStore::dim_t i,
+                     const std::vector<ReductionLevel> &levels,
+                     size_t l = 0)
+{
+    if (l == levels.size())
+        return SyntheticDataStore::value(S.idx(i));
+    const ReductionLevel &L = levels[l];
+    std::vector<double> v;
+    for (size_t k = L.k0; k < L.k1; ++k)
+    {
+        i[L.d] = k;
+        v.push_back(reduce(S, i, levels, l + 1));
+    }
+    double sum = 0.;
+    for (double x : v)
+        sum += x;
+    const double mean = sum / v.size();
+    switch (L.op)
+    {
+    case DataReduction::Sum:
+        return sum;
+    case DataReduction::Min:
+        return *std::min_element(v.begin(), v.end());
+    case DataReduction::Max:
+        return *std::max_element(v.begin(), v.end());
+    case DataReduction::Std:
+    {
+        double s2 = 0.;
+        for (double x : v)
+            s2 += (x - mean) * (x - mean);
+        return std::sqrt(s2 / v.size());
+    }
+    default:
+        return mean;
+    }
+}
+
+// compare a 2D slice to the direct reduction of its hidden dims
+inline bool compareReduced(const DataSlice &s,
+                           const SyntheticDataStore &S,
+                           const std::vector<ReductionLevel> &levels,
+                           QString &msg)
+{
+    AbstractDataStore::dim_t i(s.i0());
+    for (size_t jy = 0; jy < s.dim()[1]; ++jy)
+    {
+        for (size_t jx = 0; jx < s.dim()[0]; ++jx)
+        {
+            i[s.dx()] = jx;
+            i[s.dy()] = jy;
+            if (!nearlyEqual(s(jx, jy), reduce(S, i, levels)))
+            {
+                msg = QString("reduction mismatch at %1").arg(dimStr(i));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#endif // TESTUTIL_H
@@ -0,0 +1,97 @@
+#include "colormap.h"
+
+#include <QtTest>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+class TestColorMap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void palettes_data();
+    void palettes();
+    void lut_data();
+    void lut();
+};
+
+void TestColorMap::palettes_data()
+{
+    QTest::addColumn<int>("palette");
+    QTest::addColumn<QRgb>("first");
+    QTest::addColumn<QRgb>("last");
+
+    // the end colors of the matplotlib colormaps
+    QTest::newRow("viridis") << int(ColorMap::Viridis) << QRgb(0xff440154) << QRgb(0xfffde725);
+    QTest::newRow("turbo") << int(ColorMap::Turbo) << QRgb(0xff30123b) << QRgb(0xff7a0403);
+    QTest::newRow("jet") << int(ColorMap::Jet) << QRgb(0xff000080) << QRgb(0xff800000);
+    QTest::newRow("gray") << int(ColorMap::Gray) << QRgb(0xff000000) << QRgb(0xffffffff);
+}
+
+void TestColorMap::palettes()
+{
+    QFETCH(int, palette);
+    QFETCH(QRgb, first);
+    QFETCH(QRgb, last);
+
+    ColorMap c(static_cast<ColorMap::Palette>(palette));
+    QCOMPARE(c.color(0.), first);
+    QCOMPARE(c.color(1.), last);
+    QCOMPARE(c.color(-1.), first);
+    QCOMPARE(c.color(2.), last);
+}
+
+void TestColorMap::lut_data()
+{
+    QTest::addColumn<int>("scale");
+    QTest::addColumn<double>("lo");
+    QTest::addColumn<double>("hi");
+
+    QTest::newRow("linear") << int(ColorMap::Linear) << -1. << 2.;
+    QTest::newRow("log") << int(ColorMap::Log) << 1e-3 << 1e3;
+    QTest::newRow("symlog") << int(ColorMap::SymLog) << -1e3 << 1e2;
+}
+
+// the LUT mapping of values against the color of their direct position
+// in the transformed color range; rounding may differ by 1 LUT entry
+void TestColorMap::lut()
+{
+    QFETCH(int, scale);
+    QFETCH(double, lo);
+    QFETCH(double, hi);
+
+    ColorMap c(ColorMap::Turbo);
+    c.setScale(ColorMap::Scale(scale));
+    c.setLimits(lo, hi);
+
+    // values over & beyond the limits, nan, +-inf, 0 & negative values
+    std::vector<double> v;
+    const int n = 5000;
+    const double u0 = c.transform(lo), u1 = c.transform(hi);
+    for (int i = 0; i < n; ++i)
+        v.push_back(c.inverse(u0 + (u1 - u0) * (1.2 * i / (n - 1) - 0.1)));
+    const double inf = std::numeric_limits<double>::infinity();
+    for (double x : {lo, hi, 0., -1., inf, -inf, std::numeric_limits<double>::quiet_NaN()})
+        v.push_back(x);
+
+    std::vector<QRgb> rgb(v.size());
+    c.map(v.data(), v.size(), rgb.data());
+
+    const double step = 1. / (ColorMap::lutSize - 1);
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        double t = (c.transform(v[i]) - u0) / (u1 - u0);
+        if (std::isnan(t))
+        {
+            QVERIFY2(rgb[i] == c.nanColor(), qPrintable(QString("v = %1").arg(v[i])));
+            continue;
+        }
+        QVERIFY2(rgb[i] == c.color(t) || rgb[i] == c.color(t - step) || rgb[i] == c.color(t + step),
+                 qPrintable(QString("v = %1").arg(v[i])));
+    }
+}
+
+QTEST_MAIN(TestColorMap)
+#include "tst_colormap.moc"
@@ -0,0 +1,229 @@
+#include "qdataview.h"
+#include "syntheticstore.h"
+
+#include <QtTest>
+
+namespace {
+
+// a registered view, counting its updates
+class CountingView : public QAbstractDataView
+{
+public:
+    static CountingView *last;
+    int updates{0};
+
+    CountingView() { last = this; }
+    QWidget *view() override { return this; }
+    QIcon icon() const override { return QIcon(); }
+
+protected:
+    void updateView_() override { ++updates; }
+};
+
+CountingView *CountingView::last = nullptr;
+
+} // namespace
+
+class TestDataBrowser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void pathAdd();
+    void pathSelect();
+    void pathInvalid();
+    void pathClear();
+    void views();
+    void dataUpdatedRows();
+    void viewRejected();
+    void viewUnregister();
+
+private:
+    QDataBrowser::ViewInfo counting_;
+
+    // /g1/g2/d1, /g1/g2/g3/d2
+    static bool addTree(QDataBrowser &b);
+};
+
+void TestDataBrowser::initTestCase()
+{
+    QDataBrowser::initResources();
+
+    counting_.name = "Counting";
+    counting_.dims = 1;
+    counting_.create = [] { return new CountingView; };
+    counting_.id = QDataBrowser::registerView(counting_);
+}
+
+bool TestDataBrowser::addTree(QDataBrowser &b)
+{
+    return b.addGroup("g1") && b.addGroup("g2", "/g1") && b.addGroup("g3", "g1/g2")
+           && b.addData(new SyntheticDataStore("d1", {2, 3}), "/g1/g2")
+           && b.addData(new SyntheticDataStore("d2", {2, 3}), "g1/g2/g3");
+}
+
+void TestDataBrowser::pathAdd()
+{
+    QDataBrowser b;
+    QVERIFY(addTree(b));
+}
+
+void TestDataBrowser::pathSelect()
+{
+    QDataBrowser b;
+    QVERIFY(addTree(b));
+    QVERIFY(b.selectItem("/g1/g2/d1"));
+    QVERIFY(b.selectItem("g1/g2/g3/d2"));
+}
+
+void TestDataBrowser::pathInvalid()
+{
+    QDataBrowser b;
+    QVERIFY(addTree(b));
+    QVERIFY(!b.selectItem("/g1/missing"));
+    QVERIFY(!b.selectItem("/g1/g2/d1/x"));
+    QVERIFY(!b.addGroup("x", "/g1/g2/d1"));
+    QVERIFY(!b.addGroup("x", "/none"));
+}
+
+void TestDataBrowser::pathClear()
+{
+    QDataBrowser b;
+    QVERIFY(addTree(b));
+    b.clear("/g1/g2/g3");
+    QVERIFY(!b.selectItem("/g1/g2/g3/d2"));
+    QVERIFY(b.selectItem("/g1/g2/d1"));
+    b.clear();
+    QVERIFY(!b.selectItem("/g1"));
+}
+
+// registered views: created when shown, data routed by type & visibility
+void TestDataBrowser::views()
+{
+    const QDataBrowser::ViewType id = QDataBrowser::ViewType(counting_.id);
+    CountingView::last = nullptr;
+
+    QDataBrowser b;
+    b.addData(new SyntheticDataStore("n", {4, 5}));
+    b.addData(new SyntheticDataStore("t", {4, 5}, true));
+    b.addData(new SyntheticDataStore("m", {3, 5}));
+    b.selectItem("/n");
+    QVERIFY(!CountingView::last);
+    QCOMPARE(b.memoryUsage(id), size_t(0));
+
+    b.setActiveView(id);
+    CountingView *v = CountingView::last;
+    QVERIFY(v);
+    QCOMPARE(b.activeView(), id);
+    QVERIFY(!v->slice()->empty());
+
+    // a new selection is assigned once to the current view
+    int n = v->updates;
+    b.selectItem("/m");
+    QCOMPARE(v->updates, n + 1);
+    QCOMPARE(v->slice()->dataStore()->name(), std::string("m"));
+
+    // a hidden heavy view catches up when shown
+    b.setActiveView(QDataBrowser::Table);
+    n = v->updates;
+    b.dataUpdated("/m");
+    b.selectItem("/n");
+    QCOMPARE(v->updates, n);
+    b.setActiveView(id);
+    QCOMPARE(v->updates, n + 1);
+    QCOMPARE(v->slice()->dataStore()->name(), std::string("n"));
+
+    // text data are not routed to a numeric view, the browser
+    // switches to a view that shows them
+    b.selectItem("/t");
+    QCOMPARE(b.activeView(), QDataBrowser::Table);
+    b.setActiveView(id);
+    QVERIFY(v->slice()->empty());
+}
+
+// a data update through the browser reports the changed rows to the
+// views, e.g. for the heat map to recolor only those
+void TestDataBrowser::dataUpdatedRows()
+{
+    QDataBrowser::ViewInfo info;
+    info.name = "Rows";
+    info.dims = 2;
+    info.create = [] { return new CountingView; };
+    const QDataBrowser::ViewType id = QDataBrowser::ViewType(QDataBrowser::registerView(info));
+    {
+        QDataBrowser b;
+        SyntheticDataStore *S = new SyntheticDataStore("n", {6, 5});
+        b.addData(S);
+        b.selectItem("/n");
+        b.setActiveView(id);
+        CountingView *v = CountingView::last;
+        QVERIFY(v);
+        const DataSlice *s = v->slice();
+        QCOMPARE(s->ndim(), size_t(2));
+
+        AbstractDataStore::dim_t j(2);
+        j[s->dy()] = 3;
+        for (size_t i = 0; i < s->dim()[0]; ++i)
+        {
+            j[s->dx()] = i;
+            S->setValue(j, -1.);
+        }
+        int n = v->updates;
+        b.dataUpdated("/n");
+        QVERIFY(v->updates > n);
+        QVERIFY((s->changed_rows() == DataSlice::ranges_t{{3, 4}}));
+        QCOMPARE((*s)(2, 3), -1.);
+    }
+    QVERIFY(QDataBrowser::unregisterView(info.name));
+}
+
+// invalid registrations are rejected & leave the registry unchanged;
+// a view that is not created leaves its tab empty
+void TestDataBrowser::viewRejected()
+{
+    const int n = QDataBrowser::registeredViews().size();
+    QDataBrowser::ViewInfo v;
+    v.name = "Rejected";
+    v.dims = 1;
+    QCOMPARE(QDataBrowser::registerView(v), -1);
+    v.create = [] { return new CountingView; };
+    for (int dims : {0, 3})
+    {
+        v.dims = dims;
+        QCOMPARE(QDataBrowser::registerView(v), -1);
+    }
+    v.dims = 2;
+    v.name.clear();
+    QCOMPARE(QDataBrowser::registerView(v), -1);
+    v.name = counting_.name;
+    QCOMPARE(QDataBrowser::registerView(v), -1);
+    QCOMPARE(QDataBrowser::registeredViews().size(), n);
+
+    v.name = "Null";
+    v.create = []() -> QAbstractDataView * { return nullptr; };
+    const QDataBrowser::ViewType id = QDataBrowser::ViewType(QDataBrowser::registerView(v));
+    QVERIFY(id >= 0);
+    {
+        QDataBrowser b;
+        b.addData(new SyntheticDataStore("n", {4, 5}));
+        b.selectItem("/n");
+        b.setActiveView(id);
+        QCOMPARE(b.activeView(), id);
+        QCOMPARE(b.memoryUsage(id), size_t(0));
+        b.dataUpdated("/n");
+        b.selectItem("/n");
+    }
+    QVERIFY(QDataBrowser::unregisterView(v.name));
+}
+
+void TestDataBrowser::viewUnregister()
+{
+    QVERIFY(QDataBrowser::unregisterView(counting_.name));
+    QDataBrowser b;
+    b.setActiveView(QDataBrowser::ViewType(counting_.id));
+    QCOMPARE(b.activeView(), QDataBrowser::Table);
+}
+
+QTEST_MAIN(TestDataBrowser)
+#include "tst_databrowser.moc"
@@ -0,0 +1,616 @@
+#include "dataslice.h"
+#include "testutil.h"
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// parse a numeric CSV into rows of values
+std::vector<std::vector<double>> parseCsv(const std::string &str, bool skipHeader)
+{
+    std::vector<std::vector<double>> rows;
+    std::istringstream is(str);
+    std::string line;
+    if (skipHeader)
+        std::getline(is, line);
+    while (std::getline(is, line))
+    {
+        std::vector<double> row;
+        std::istringstream ls(line);
+        std::string v;
+        while (std::getline(ls, v, ','))
+            row.push_back(std::stod(v));
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+// nx x ny x nz store overwritten by a producer thread, each write fills
+// it with one value
+class FrameStore : public AbstractDataStore
+{
+public:
+    FrameStore(size_t nx, size_t ny, size_t nz)
+        : AbstractDataStore("frames", {nx, ny, nz}), v_(nx * ny * nz, 0.)
+    {
+    }
+    void write(double x)
+    {
+        begin_write();
+        std::fill(v_.begin(), v_.end(), x);
+        end_write();
+    }
+
+protected:
+    vec_t v_;
+
+    size_t get_y(size_t d, const dim_t &i0, size_t n, double *v) const override
+    {
+        size_t k = i0[0] + dim_[0] * (i0[1] + dim_[1] * i0[2]);
+        size_t stride = d == 0 ? 1 : (d == 1 ? dim_[0] : dim_[0] * dim_[1]);
+        size_t m = std::min(n, dim_[d] - i0[d]);
+        for (size_t i = 0; i < m; ++i)
+            v[i] = v_[k + i * stride];
+        return m;
+    }
+};
+
+// store with categorical dims, counting the fetches of the categories
+class CategoryStore : public AbstractDataStore
+{
+public:
+    mutable int fetches{0};
+
+    CategoryStore()
+        : AbstractDataStore("categories", {50, 40, 1})
+    {
+    }
+    bool is_x_categorical(size_t d) const override { return d != 1; }
+    size_t get_x_categorical(size_t d, strvec_t &x) const override
+    {
+        ++fetches;
+        for (size_t i = 0; i < x.size(); ++i)
+            x[i] = std::to_string(d) + "_" + std::to_string(i);
+        return x.size();
+    }
+
+protected:
+    size_t get_y(size_t d, const dim_t &i0, size_t n, double *v) const override
+    {
+        size_t m = std::min(n, dim_[d] - i0[d]);
+        std::fill(v, v + m, 1.);
+        return m;
+    }
+};
+
+// a slice exposing the number of incremental window steps
+class WindowSlice : public DataSlice
+{
+public:
+    size_t windowSteps() const { return wsteps_; }
+};
+
+} // namespace
+
+class TestDataSlice : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void axes_data();
+    void axes();
+    void squeezed();
+    void squeezedScalar();
+    void csv2dErrors();
+    void csv1dErrors();
+    void csvText();
+    void concurrentWrites();
+    void updateRange();
+    void updateRows();
+    void updateVersion();
+    void categories();
+    void reductions_data();
+    void reductions();
+    void windowScrub_data();
+    void windowScrub();
+    void windowResum();
+    void bufferReuse();
+    void textIds();
+    void budget_data();
+    void budget();
+};
+
+void TestDataSlice::axes_data()
+{
+    QTest::addColumn<DataStorePtr>("store");
+
+    QTest::newRow("numeric") << DataStorePtr(new SyntheticDataStore("n", {4, 5, 6, 7}));
+    QTest::newRow("errors") << DataStorePtr(new SyntheticDataStore("e", {4, 5, 6}, false, true));
+    QTest::newRow("procedural")
+        << DataStorePtr(new SyntheticDataStore("p", {4, 5, 6}, false, true, false));
+    QTest::newRow("text") << DataStorePtr(new SyntheticDataStore("t", {3, 4, 5}, true));
+}
+
+// 1D slices along every axis, 2D slices on every axis pair
+void TestDataSlice::axes()
+{
+    QFETCH(DataStorePtr, store);
+    const SyntheticDataStore &S = synthetic(store);
+    size_t ndim = store->ndim();
+    AbstractDataStore::dim_t i0(ndim);
+    for (size_t d = 0; d < ndim; ++d)
+        i0[d] = store->dim()[d] / 2;
+
+    DataSlice s;
+    QString msg;
+    for (size_t dx = 0; dx < ndim; ++dx)
+    {
+        s.assign(store, dx, i0);
+        QCOMPARE(s.ndim(), size_t(1));
+        QCOMPARE(s.dim()[0], store->dim()[dx]);
+        QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+    }
+
+    for (size_t dx = 0; dx < ndim; ++dx)
+    {
+        for (size_t dy = 0; dy < ndim; ++dy)
+        {
+            if (dx == dy)
+                continue;
+            s.assign(store, dx, dy, i0);
+            QCOMPARE(s.ndim(), size_t(2));
+            QCOMPARE(s.dim()[0], store->dim()[dx]);
+            QCOMPARE(s.dim()[1], store->dim()[dy]);
+            QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+        }
+    }
+
+    // move the offset & refetch
+    s.assign(store, 0, 1, i0);
+    AbstractDataStore::dim_t i1(i0);
+    i1[2] = 0;
+    s.assign(i1);
+    QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+}
+
+void TestDataSlice::squeezed()
+{
+    DataStorePtr D(new SyntheticDataStore("squeeze", {1, 4, 1, 5, 1}, false, true));
+    const SyntheticDataStore &S = synthetic(D);
+    DataStorePtr Q(new SqueezedDataStore(D));
+
+    QCOMPARE(Q->ndim(), size_t(2));
+    QCOMPARE(Q->dim()[0], size_t(4));
+    QCOMPARE(Q->dim()[1], size_t(5));
+    QCOMPARE(Q->dim_name(0), D->dim_name(1));
+    QCOMPARE(Q->dim_name(1), D->dim_name(3));
+
+    // squeezed index (i,j) -> original (0,i,0,j,0)
+    auto map = [](const AbstractDataStore::dim_t &i) -> AbstractDataStore::dim_t {
+        return {0, i[0], 0, i[1], 0};
+    };
+    DataSlice s;
+    QString msg;
+    const size_t pairs[2][2] = {{0, 1}, {1, 0}};
+    for (int k = 0; k < 2; ++k)
+    {
+        s.assign(Q, pairs[k][0], pairs[k][1], {0, 0});
+        QVERIFY2(compareSlice(s, S, map, msg), qPrintable(msg));
+    }
+    for (size_t d = 0; d < 2; ++d)
+    {
+        s.assign(Q, d, {1, 2});
+        QVERIFY2(compareSlice(s, S, map, msg), qPrintable(msg));
+    }
+}
+
+void TestDataSlice::squeezedScalar()
+{
+    DataStorePtr Z(new SyntheticDataStore("scalar", {1, 1}));
+    DataStorePtr Q(new SqueezedDataStore(Z));
+    QCOMPARE(Q->ndim(), size_t(1));
+    QVERIFY(Q->is_scalar());
+}
+
+// 2D with errors: row i = y(i,0), dy(i,0), y(i,1), dy(i,1), ...
+void TestDataSlice::csv2dErrors()
+{
+    DataStorePtr D(new SyntheticDataStore("csv", {3, 4}, false, true));
+    DataSlice s;
+    std::ostringstream os;
+    s.assign(D, 0, 1, {0, 0});
+    s.export_csv(os);
+    auto rows = parseCsv(os.str(), false);
+    QCOMPARE(rows.size(), size_t(3));
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        QCOMPARE(rows[i].size(), size_t(8));
+        for (size_t j = 0; j < 4; ++j)
+        {
+            QVERIFY(nearlyEqual(rows[i][2 * j], s(i, j)));
+            QVERIFY(nearlyEqual(rows[i][2 * j + 1], s.errors()[i + 3 * j]));
+        }
+    }
+}
+
+// 1D with errors: x, y, dy
+void TestDataSlice::csv1dErrors()
+{
+    DataStorePtr D(new SyntheticDataStore("csv", {3, 4}, false, true));
+    DataSlice s;
+    std::ostringstream os;
+    s.assign(D, 1, {2, 0});
+    s.export_csv(os);
+    QVERIFY(os.str().rfind("x,y,dy\n", 0) == 0);
+    auto rows = parseCsv(os.str(), true);
+    QCOMPARE(rows.size(), size_t(4));
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        QCOMPARE(rows[i].size(), size_t(3));
+        QVERIFY(nearlyEqual(rows[i][0], s.x(i)));
+        QVERIFY(nearlyEqual(rows[i][1], s(i)));
+        QVERIFY(nearlyEqual(rows[i][2], s.errors()[i]));
+    }
+}
+
+void TestDataSlice::csvText()
+{
+    DataStorePtr T(new SyntheticDataStore("csvtext", {2, 2}, true));
+    DataSlice s;
+    std::ostringstream os;
+    s.assign(T, 0, 1, {0, 0});
+    s.export_csv(os);
+    std::ostringstream ref;
+    for (size_t i = 0; i < 2; ++i)
+        ref << std::quoted(s.text_data(i, 0)) << ", " << std::quoted(s.text_data(i, 1)) << std::endl;
+    QCOMPARE(os.str(), ref.str());
+}
+
+// slices read while the store is written must hold a single frame
+void TestDataSlice::concurrentWrites()
+{
+    FrameStore *F = new FrameStore(256, 256, 3);
+    DataStorePtr D(F);
+    DataSlice s;
+    s.assign(D, 0, 1, {0, 0, 1});
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        for (double x = 1; !stop; ++x)
+        {
+            F->write(x);
+            std::this_thread::sleep_for(std::chrono::microseconds(300));
+        }
+    });
+    auto single = [](const AbstractDataStore::vec_t &v) {
+        return std::all_of(v.begin(), v.end(), [&](double x) { return x == v[0]; });
+    };
+    bool ok = true, okFetch = true;
+    AbstractDataStore::vec_t y, e;
+    for (int k = 0; k < 500; ++k)
+    {
+        s.update();
+        ok = ok && single(s.data());
+        s.fetch({0, 0, 2}, y, e);
+        okFetch = okFetch && single(y);
+    }
+    stop = true;
+    writer.join();
+    QVERIFY2(ok, "torn frame in update()");
+    QVERIFY2(okFetch, "torn frame in fetch()");
+}
+
+// ranged updates: a hidden dim outside the slice, a range of rows
+void TestDataSlice::updateRange()
+{
+    FrameStore *F = new FrameStore(256, 256, 3);
+    DataStorePtr D(F);
+    DataSlice s;
+    s.assign(D, 0, 1, {0, 0, 1});
+    F->write(1);
+    s.update();
+    s.update(2, 2, 3);
+    QVERIFY(s.changed_rows().empty());
+    F->write(-1);
+    s.update(1, 10, 20);
+    QVERIFY((s.changed_rows() == DataSlice::ranges_t{{10, 20}}));
+    QCOMPARE(s(0, 10), -1.);
+    QCOMPARE(s(0, 9), 1.);
+}
+
+// a full update reports the rows that differ only
+void TestDataSlice::updateRows()
+{
+    DataStorePtr D(new SyntheticDataStore("rows", {16, 12, 2}));
+    DataSlice s;
+    s.assign(D, 0, 1, {0, 0, 1});
+    QVERIFY(s.all_rows_changed());
+
+    s.update();
+    QVERIFY(s.changed_rows().empty());
+    for (size_t j : {3, 4, 9})
+        synthetic(D).setValue({5, j, 1}, -1.);
+    synthetic(D).setValue({5, 6, 0}, -1.);
+    s.update();
+    QVERIFY((s.changed_rows() == DataSlice::ranges_t{{3, 5}, {9, 10}}));
+    QCOMPARE(s(5, 4), -1.);
+    QCOMPARE(s(5, 6), SyntheticDataStore::value(synthetic(D).idx({5, 6, 1})));
+
+    // 1D: nothing changed, as if an empty tail was appended
+    s.assign(D, 0, {0, 2, 1});
+    s.update();
+    QVERIFY(s.changed_rows().empty());
+    QCOMPARE(s.appended_from(), size_t(16));
+}
+
+// a full read is current until the next write
+void TestDataSlice::updateVersion()
+{
+    FrameStore *F = new FrameStore(16, 16, 3);
+    DataStorePtr D(F);
+    DataSlice s;
+    s.assign(D, 0, 1, {0, 0, 1});
+    F->write(1);
+    s.update();
+    QVERIFY(s.is_current());
+    F->write(2);
+    QVERIFY(!s.is_current());
+    s.update();
+    QVERIFY(s.is_current());
+    QCOMPARE(s(0, 0), 2.);
+}
+
+// categories are fetched once per dim, also for a store that does not
+// track its version, & shared through a squeezed proxy; value changes keep
+// them, a resize or categories_changed() fetches them again
+void TestDataSlice::categories()
+{
+    CategoryStore *C = new CategoryStore;
+    DataStorePtr D(C);
+    D->categories(0);
+    D->categories(0);
+    QCOMPARE(C->fetches, 1);
+
+    C->changed();
+    DataStorePtr Q(new SqueezedDataStore(D));
+    DataSlice s;
+    for (int k = 0; k < 4; ++k)
+    {
+        s.assign(Q, 0, 1, {0, 0});
+        s.assign(Q, 1, 0, {0, 0});
+        C->changed();
+    }
+    QCOMPARE(C->fetches, 1);
+    QVERIFY(!s.is_x_categorical(0));
+    QVERIFY(s.is_x_categorical(1));
+    QVERIFY(s.categories(1) == D->categories(0));
+    QCOMPARE(s.y_category()[7], std::string("0_7"));
+
+    C->categories_changed();
+    s.assign(Q, 0, 1, {0, 0});
+    QCOMPARE(C->fetches, 2);
+    QCOMPARE(s.x_category().size(), size_t(50));
+
+    C->begin_resize();
+    C->end_resize();
+    s.assign(Q, 0, 1, {0, 0});
+    QCOMPARE(C->fetches, 3);
+}
+
+void TestDataSlice::reductions_data()
+{
+    QTest::addColumn<int>("op");
+    QTest::addColumn<int>("threads");
+
+    for (int nt : {1, 4})
+    {
+        QTest::addRow("sum_threads%d", nt) << int(DataReduction::Sum) << nt;
+        QTest::addRow("mean_threads%d", nt) << int(DataReduction::Mean) << nt;
+        QTest::addRow("min_threads%d", nt) << int(DataReduction::Min) << nt;
+        QTest::addRow("max_threads%d", nt) << int(DataReduction::Max) << nt;
+        QTest::addRow("std_threads%d", nt) << int(DataReduction::Std) << nt;
+    }
+}
+
+// a reduction of a hidden dim against a direct computation, in the
+// calling thread & split among worker threads (the slice is large enough)
+void TestDataSlice::reductions()
+{
+    QFETCH(int, op);
+    QFETCH(int, threads);
+
+    DataStorePtr D(new SyntheticDataStore("r", {64, 48, 25}));
+    DataReduction::setMaxThreads(threads);
+    DataSlice s;
+    s.assign(D, 0, 1, {0, 0, 3});
+    s.set_reduction(2, DataReduction::op_t(op));
+    s.update();
+    DataReduction::setMaxThreads(0);
+
+    QVERIFY(!s.canceled());
+    QString msg;
+    QVERIFY2(compareReduced(s, synthetic(D), {{2, DataReduction::op_t(op), 0, 25}}, msg),
+             qPrintable(msg));
+}
+
+void TestDataSlice::windowScrub_data()
+{
+    QTest::addColumn<DataStorePtr>("store");
+    QTest::addColumn<bool>("sum");
+
+    QTest::newRow("window") << DataStorePtr(new SyntheticDataStore("w", {24, 16, 40})) << false;
+    QTest::newRow("window_sum")
+        << DataStorePtr(new SyntheticDataStore("ws", {24, 16, 40, 3})) << true;
+}
+
+// a window moved by steps, back & forth & by jumps, against the direct
+// average; steps shorter than the window update the running sum, others
+// recompute it
+void TestDataSlice::windowScrub()
+{
+    QFETCH(DataStorePtr, store);
+    QFETCH(bool, sum);
+    const size_t w = 8;
+
+    DataSlice s;
+    AbstractDataStore::dim_t i0(store->ndim(), 0);
+    s.assign(store, 0, 1, i0);
+    s.set_window(2, w);
+    if (sum)
+        s.set_reduction(3, DataReduction::Sum);
+    s.update();
+
+    QString msg;
+    for (size_t k : {1, 2, 3, 5, 4, 10, 20, 19, 32, 31, 25, 0})
+    {
+        i0[2] = k;
+        s.assign(i0);
+        std::vector<ReductionLevel> levels{{2, DataReduction::Mean, k, k + w}};
+        if (sum)
+            levels.push_back({3, DataReduction::Sum, 0, 3});
+        QVERIFY2(compareReduced(s, synthetic(store), levels, msg),
+                 qPrintable(QString("i0=%1: ").arg(k) + msg));
+    }
+}
+
+// the running sum is recomputed after a max number of steps, so that
+// round-off does not accumulate
+void TestDataSlice::windowResum()
+{
+    DataStorePtr D(new SyntheticDataStore("w", {4, 3, 6}));
+    WindowSlice s;
+    AbstractDataStore::dim_t i0{0, 0, 0};
+    s.assign(D, 0, 1, i0);
+    s.set_window(2, 3);
+    s.update();
+    QCOMPARE(s.windowSteps(), size_t(0));
+
+    size_t maxSteps = 0;
+    bool resummed = false;
+    for (int k = 1; k <= 1100; ++k)
+    {
+        i0[2] = k % 2;
+        s.assign(i0);
+        if (s.windowSteps() < maxSteps)
+            resummed = true;
+        maxSteps = std::max(maxSteps, s.windowSteps());
+    }
+    QCOMPARE(maxSteps, size_t(1024));
+    QVERIFY(resummed);
+
+    QString msg;
+    QVERIFY2(compareReduced(s, synthetic(D), {{2, DataReduction::Mean, i0[2], i0[2] + 3}}, msg),
+             qPrintable(msg));
+}
+
+// reassignments to other axes & stores reuse the buffers
+void TestDataSlice::bufferReuse()
+{
+    DataStorePtr D(new SyntheticDataStore("b", {300, 200, 4}, false, true));
+    DataStorePtr E(new SyntheticDataStore("c", {200, 300}, false, true));
+    const SyntheticDataStore &S = synthetic(D);
+    DataSlice s;
+    QString msg;
+    s.assign(D, 0, 1, {0, 0, 1});
+    const double *data = s.data().data(), *errors = s.errors().data();
+
+    s.assign(D, 1, 0, {0, 0, 1});
+    QCOMPARE(s.data().data(), data);
+    QCOMPARE(s.errors().data(), errors);
+    QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+
+    s.assign(E, 0, 1, {0, 0});
+    QCOMPARE(s.data().data(), data);
+
+    // smaller: the capacity is kept until shrink()
+    s.assign(D, 0, 2, {0, 0, 1});
+    QCOMPARE(s.data().data(), data);
+    QVERIFY(s.unused_capacity() > 0);
+    QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+    s.shrink();
+    QCOMPARE(s.unused_capacity(), size_t(0));
+    QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+}
+
+// text values are interned: each distinct value is stored once, every
+// cell refers to it by id
+void TestDataSlice::textIds()
+{
+    DataStorePtr D(new SyntheticDataStore("t", {40, 30, 2}, true));
+    const SyntheticDataStore &S = synthetic(D);
+    DataSlice s;
+    QString msg;
+    for (int k = 0; k < 3; ++k)
+    {
+        // text after numeric data & after a larger text slice
+        if (k == 1)
+            s.assign(DataStorePtr(new SyntheticDataStore("n", {40, 30})), 0, 1, {0, 0});
+        s.assign(D, 0, k == 2 ? 2 : 1, {0, 0, 1});
+        QVERIFY2(compareSlice(s, S, identity, msg), qPrintable(msg));
+
+        std::set<std::string_view> distinct;
+        for (uint32_t id = 0; id < s.text_count(); ++id)
+            distinct.insert(s.text(id));
+        QCOMPARE(distinct.size(), s.text_count());
+
+        std::set<std::string> values;
+        AbstractDataStore::dim_t i(s.i0());
+        for (size_t jy = 0; jy < s.dim()[1]; ++jy)
+        {
+            for (size_t jx = 0; jx < s.dim()[0]; ++jx)
+            {
+                QVERIFY(s.text_id(jx, jy) < s.text_count());
+                i[s.dx()] = jx;
+                i[s.dy()] = jy;
+                values.insert(SyntheticDataStore::text(S.idx(i)));
+            }
+        }
+        QCOMPARE(values.size(), s.text_count());
+    }
+}
+
+void TestDataSlice::budget_data()
+{
+    QTest::addColumn<size_t>("dx");
+    QTest::addColumn<size_t>("dy");
+
+    QTest::newRow("dx0") << size_t(0) << size_t(1);
+    QTest::newRow("dx1") << size_t(1) << size_t(0);
+}
+
+// max time to assemble a 2000x2000 slice, best of 3
+// QTDATABROWSER_BUDGET_MS overrides the default for slow machines
+void TestDataSlice::budget()
+{
+    QFETCH(size_t, dx);
+    QFETCH(size_t, dy);
+
+    double budget_ms = 250;
+    if (!qEnvironmentVariableIsEmpty("QTDATABROWSER_BUDGET_MS"))
+        budget_ms = qEnvironmentVariable("QTDATABROWSER_BUDGET_MS").toDouble();
+
+    DataStorePtr D(new SyntheticDataStore("budget", {2000, 2000}));
+    DataSlice s;
+    QElapsedTimer tmr;
+    double tmin = 0;
+    for (int r = 0; r < 3; ++r)
+    {
+        tmr.start();
+        s.assign(D, dx, dy, {0, 0});
+        double t = tmr.nsecsElapsed() * 1e-6;
+        tmin = r ? std::min(tmin, t) : t;
+    }
+    QVERIFY2(tmin <= budget_ms, qPrintable(QString("%1 ms (budget %2 ms)").arg(tmin).arg(budget_ms)));
+}
+
+QTEST_MAIN(TestDataSlice)
+#include "tst_dataslice.moc"
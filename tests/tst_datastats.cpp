@@ -0,0 +1,177 @@
+#include "datastats.h"
+#include "testutil.h"
+
+#include <QtTest>
+
+#include <algorithm>
+
+Q_DECLARE_METATYPE(AbstractDataStore::dim_t)
+
+class TestDataStats : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+    void global_data();
+    void global();
+    void rebin_data();
+    void rebin();
+    void coalesce();
+};
+
+void TestDataStats::cleanup()
+{
+    DataReduction::setMaxThreads(0);
+}
+
+void TestDataStats::global_data()
+{
+    QTest::addColumn<AbstractDataStore::dim_t>("shape");
+    QTest::addColumn<int>("threads");
+
+    for (int nt : {1, 4})
+    {
+        QTest::addRow("7_threads%d", nt) << AbstractDataStore::dim_t{7} << nt;
+        QTest::addRow("300x200x5_threads%d", nt) << AbstractDataStore::dim_t{300, 200, 5} << nt;
+    }
+}
+
+// global stats against a direct two-pass computation
+void TestDataStats::global()
+{
+    QFETCH(AbstractDataStore::dim_t, shape);
+    QFETCH(int, threads);
+
+    SyntheticDataStore S("s", shape);
+    DataReduction::setMaxThreads(threads);
+    DataStats st;
+    QVERIFY(DataStats::compute(S, st));
+
+    const size_t n = S.size();
+    double mn = SyntheticDataStore::value(0), mx = mn, sum = 0., s2 = 0.;
+    for (size_t k = 0; k < n; ++k)
+    {
+        double v = SyntheticDataStore::value(k);
+        mn = std::min(mn, v);
+        mx = std::max(mx, v);
+        sum += v;
+    }
+    double mean = sum / n;
+    for (size_t k = 0; k < n; ++k)
+    {
+        double d = SyntheticDataStore::value(k) - mean;
+        s2 += d * d;
+    }
+    size_t hsum = 0;
+    for (size_t h : st.hist)
+        hsum += h;
+
+    QCOMPARE(st.count, n);
+    QCOMPARE(st.nan, size_t(0));
+    QCOMPARE(st.min, mn);
+    QCOMPARE(st.max, mx);
+    QVERIFY(nearlyEqual(st.mean, mean));
+    QVERIFY(nearlyEqual(st.var, s2 / n));
+    QCOMPARE(hsum, n);
+    QVERIFY(st.hist_lo <= mn);
+    QVERIFY(st.hist_hi() > mx);
+}
+
+void TestDataStats::rebin_data()
+{
+    QTest::addColumn<int>("bins");
+
+    for (int n : {1, 7, 64, 1000})
+        QTest::addRow("%d", n) << n;
+}
+
+// the histograms of any bins & range are rebinned from the fine histogram:
+// exact on fine bin edges, otherwise off by at most the counts of the
+// fine bins split at the bin edges
+void TestDataStats::rebin()
+{
+    QFETCH(int, bins);
+
+    SyntheticDataStore S("s", {300, 200, 5});
+    DataStats st;
+    QVERIFY(DataStats::compute(S, st));
+    const size_t n = S.size();
+
+    // the whole fine histogram
+    std::vector<double> h = st.histogram(bins, st.hist_lo, st.hist_hi());
+    double total = 0.;
+    for (double c : h)
+        total += c;
+    QVERIFY(nearlyEqual(total, n));
+
+    // each bin is 4 fine bins
+    const size_t m = st.hist.size() / 4;
+    h = st.histogram(m, st.hist_lo, st.hist_lo + 4 * m * st.hist_width);
+    for (size_t k = 0; k < m; ++k)
+    {
+        size_t c = 0;
+        for (size_t j = 4 * k; j < 4 * k + 4; ++j)
+            c += st.hist[j];
+        QVERIFY(nearlyEqual(h[k], c));
+    }
+
+    // direct binning of the values over [min, max]
+    const double lo = st.min, hi = st.max;
+    std::vector<size_t> direct(bins, 0);
+    for (size_t k = 0; k < n; ++k)
+    {
+        double v = SyntheticDataStore::value(k);
+        size_t j = size_t((v - lo) / (hi - lo) * bins);
+        direct[std::min(j, size_t(bins) - 1)]++;
+    }
+    auto fineCount = [&st](double x) -> double {
+        double j = std::floor((x - st.hist_lo) / st.hist_width);
+        return j >= 0 && j < st.hist.size() ? st.hist[size_t(j)] : 0.;
+    };
+    h = st.histogram(bins, lo, hi);
+    for (int k = 0; k < bins; ++k)
+    {
+        double e0 = lo + (hi - lo) * k / bins, e1 = lo + (hi - lo) * (k + 1) / bins;
+        double tol = fineCount(e0) + fineCount(e1) + 1e-6 * n;
+        QVERIFY2(std::abs(h[k] - direct[k]) <= tol,
+                 qPrintable(QString("bin %1: %2 vs %3").arg(k).arg(h[k]).arg(direct[k])));
+    }
+}
+
+// changes during a pass do not cancel it: its stats are delivered, marked
+// stale, and a single pass follows for all the changes
+void TestDataStats::coalesce()
+{
+    DataStorePtr D(new SyntheticDataStore("coalesce", {2000, 2000}));
+    DataStatsCache cache;
+    std::vector<bool> staleAtReady;
+    connect(&cache, &DataStatsCache::statsReady, [&](const AbstractDataStore *d) {
+        QCOMPARE(d, D.data());
+        QVERIFY(cache.stats(d));
+        staleAtReady.push_back(cache.stale(d));
+    });
+
+    cache.request(D);
+    QVERIFY(cache.pending(D.data()));
+    for (int k = 0; k < 100; ++k)
+    {
+        cache.invalidate(D.data());
+        cache.request(D);
+    }
+    QTRY_COMPARE(staleAtReady.size(), size_t(2));
+    QTest::qWait(50);
+    QCOMPARE(staleAtReady, (std::vector<bool>{true, false}));
+    QVERIFY(!cache.pending(D.data()) && !cache.stale(D.data()));
+
+    // a change after the last pass keeps the stats until the next request
+    cache.invalidate(D.data());
+    QVERIFY(cache.stats(D.data()) && cache.stale(D.data()));
+    QVERIFY(!cache.pending(D.data()));
+    cache.request(D);
+    QTRY_COMPARE(staleAtReady.size(), size_t(3));
+    QVERIFY(!staleAtReady.back());
+}
+
+QTEST_MAIN(TestDataStats)
+#include "tst_datastats.moc"
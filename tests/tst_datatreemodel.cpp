@@ -0,0 +1,199 @@
+#include "datatreemodel.h"
+
+#include <QAbstractItemModelTester>
+#include <QtTest>
+
+class TestDataTreeModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void addRemove();
+    void pending();
+    void lazy();
+    void names();
+    void stringReuse();
+    void clear();
+
+private:
+    DataTreeModel *model_{nullptr};
+    QAbstractItemModelTester *tester_{nullptr};
+};
+
+// every test runs the model tester, which checks the consistency of the
+// model after each change signal
+void TestDataTreeModel::init()
+{
+    model_ = new DataTreeModel(this);
+    tester_ = new QAbstractItemModelTester(model_,
+                                           QAbstractItemModelTester::FailureReportingMode::QtTest,
+                                           this);
+}
+
+void TestDataTreeModel::cleanup()
+{
+    delete tester_;
+    delete model_;
+    tester_ = nullptr;
+    model_ = nullptr;
+}
+
+void TestDataTreeModel::addRemove()
+{
+    DataTreeModel &m = *model_;
+    int g1 = m.add(DataTreeModel::root, "g1", "group 1", true);
+    int g2 = m.add(g1, "g2", QString(), true);
+    int d1 = m.add(g2, "d1", "data 1", false);
+    int d2 = m.add(g1, "d2", QString(), false);
+
+    QCOMPARE(m.rowCount(), 1);
+    QCOMPARE(m.rowCount(m.indexOf(g1)), 2);
+    QCOMPARE(m.id(m.index(0, 0, m.indexOf(g2))), d1);
+    QCOMPARE(m.parent(m.indexOf(d1)), m.indexOf(g2));
+    QCOMPARE(m.path(d1), QString("/g1/g2/d1"));
+    QCOMPARE(m.find(g1, "d2"), d2);
+    QCOMPARE(m.data(m.indexOf(d1), Qt::ToolTipRole).toString(), QString("data 1"));
+    QVERIFY(m.isGroup(g2) && !m.isGroup(d2));
+
+    // removing a row renumbers its siblings
+    m.remove(g2);
+    QCOMPARE(m.rowCount(m.indexOf(g1)), 1);
+    QCOMPARE(m.indexOf(d2).row(), 0);
+    QCOMPARE(m.find(g1, "g2"), -1);
+    QVERIFY(!m.indexOf(d1).isValid());
+
+    // ids of removed nodes are reused
+    int d3 = m.add(g1, "d3", QString(), false);
+    QVERIFY(d3 == g2 || d3 == d1);
+    QCOMPARE(m.path(d3), QString("/g1/d3"));
+    QCOMPARE(m.indexOf(d3).row(), 1);
+
+    m.remove(g1);
+    QCOMPARE(m.rowCount(), 0);
+}
+
+// deferred rows are inserted at once; their children are added directly
+void TestDataTreeModel::pending()
+{
+    DataTreeModel &m = *model_;
+    int g = m.add(DataTreeModel::root, "g", QString(), true);
+    m.add(g, "a", QString(), false);
+    int h = m.add(g, "h", QString(), true, true);
+    int b = m.add(g, "b", QString(), false, true);
+    int c = m.add(h, "c", QString(), false, true);
+    QCOMPARE(m.rowCount(m.indexOf(g)), 1);
+    QVERIFY(!m.indexOf(h).isValid());
+    QCOMPARE(int(m.children(h).size()), 1);
+
+    // a deferred node is not removed before it is inserted
+    m.remove(b);
+    QCOMPARE(m.find(g, "b"), b);
+
+    m.insertPending();
+    QCOMPARE(m.rowCount(m.indexOf(g)), 3);
+    QCOMPARE(m.indexOf(h).row(), 1);
+    QCOMPARE(m.indexOf(b).row(), 2);
+    QCOMPARE(m.parent(m.indexOf(c)), m.indexOf(h));
+    QCOMPARE(m.rowCount(m.indexOf(h)), 1);
+}
+
+// lazy groups list their children when expanded
+void TestDataTreeModel::lazy()
+{
+    DataTreeModel &m = *model_;
+    int g = m.add(DataTreeModel::root, "lazy", QString(), true);
+    m.setLazy(g, true);
+    int fetched = 0;
+    m.fetch = [&m, &fetched](int id) {
+        ++fetched;
+        m.setLazy(id, false);
+        for (int k = 0; k < 3; ++k)
+            m.add(id, QString("d%1").arg(k), QString(), false, true);
+        m.insertPending();
+    };
+    QModelIndex i = m.indexOf(g);
+    QVERIFY(m.hasChildren(i));
+    QCOMPARE(m.rowCount(i), 0);
+    QVERIFY(m.canFetchMore(i));
+    m.fetchMore(i);
+    QCOMPARE(fetched, 1);
+    QVERIFY(!m.canFetchMore(i));
+    QCOMPARE(m.rowCount(i), 3);
+    QCOMPARE(m.path(m.find(g, "d2")), QString("/lazy/d2"));
+}
+
+// names & descriptions are shared in the string pool
+void TestDataTreeModel::names()
+{
+    DataTreeModel &m = *model_;
+    int g1 = m.add(DataTreeModel::root, "g1", "same", true);
+    int g2 = m.add(DataTreeModel::root, "g2", "same", true);
+    int a1 = m.add(g1, "a", QString(), false);
+    int a2 = m.add(g2, "a", QString(), false);
+
+    // a sibling of the same name takes the place of the removed node
+    int a3 = m.add(g2, "a", QString(), false);
+    QCOMPARE(m.find(g2, "a"), a2);
+    m.remove(a2);
+    QCOMPARE(m.find(g2, "a"), a3);
+    QCOMPARE(m.find(g1, "a"), a1);
+    m.remove(a1);
+    QCOMPARE(m.find(g2, "a"), a3);
+    QCOMPARE(m.name(a3), QString("a"));
+
+    m.setDescription(g1, "other");
+    QCOMPARE(m.description(g1), QString("other"));
+    QCOMPARE(m.description(g2), QString("same"));
+    m.setDescription(g2, "other");
+    m.setDescription(g1, QString());
+    QCOMPARE(m.description(g2), QString("other"));
+    QCOMPARE(m.data(m.indexOf(g1), Qt::ToolTipRole).toString(), QString("Group"));
+}
+
+// the strings of removed nodes are released & their ids reused, so that
+// adding & removing nodes of new names does not grow the pool
+void TestDataTreeModel::stringReuse()
+{
+    DataTreeModel &m = *model_;
+    int g = m.add(DataTreeModel::root, "g", QString(), true);
+    size_t usage = 0;
+    for (int cycle = 0; cycle < 5; ++cycle)
+    {
+        std::vector<int> ids;
+        for (int k = 0; k < 100; ++k)
+            ids.push_back(m.add(g,
+                                QString("n%1_%2").arg(cycle).arg(k, 3, 10, QChar('0')),
+                                QString("d%1_%2").arg(cycle).arg(k, 3, 10, QChar('0')),
+                                false));
+        QCOMPARE(m.name(ids[42]), QString("n%1_042").arg(cycle));
+        QCOMPARE(m.description(ids[42]), QString("d%1_042").arg(cycle));
+        for (int id : ids)
+            m.remove(id);
+        QCOMPARE(m.find(g, QString("n%1_042").arg(cycle)), -1);
+        if (cycle == 0)
+            usage = m.memoryUsage();
+        QCOMPARE(m.memoryUsage(), usage);
+    }
+}
+
+void TestDataTreeModel::clear()
+{
+    DataTreeModel &m = *model_;
+    int g = m.add(DataTreeModel::root, "g", "desc", true);
+    m.add(g, "d", QString(), false);
+    m.add(g, "e", QString(), false, true);
+    m.clear();
+    QCOMPARE(m.rowCount(), 0);
+    QCOMPARE(m.find(DataTreeModel::root, "g"), -1);
+    m.insertPending();
+    QCOMPARE(m.rowCount(), 0);
+
+    g = m.add(DataTreeModel::root, "g", QString(), true);
+    QCOMPARE(m.find(DataTreeModel::root, "g"), g);
+    QCOMPARE(m.description(g), QString());
+}
+
+QTEST_MAIN(TestDataTreeModel)
+#include "tst_datatreemodel.moc"
@@ -0,0 +1,134 @@
+#include "qdataview.h"
+#include "qheatmapwidget.h"
+#include "testutil.h"
+
+#include <QtTest>
+
+class TestDataViews : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void heatMapRows();
+    void heatMapRowsRange();
+    void heatMapRowsUpdate();
+    void heatMapRowsAutoLimits();
+
+private:
+    DataStorePtr D_;
+    DataSlice slice_;
+    QHeatMapDataView *view_{nullptr};
+    QHeatMapWidget *heatMap_{nullptr};
+
+    // the image of the whole slice, mapped at once
+    QImage fullImage() const;
+    // overwrite row j of the slice in the store
+    void setRow(size_t j, double v);
+};
+
+void TestDataViews::init()
+{
+    D_ = DataStorePtr(new SyntheticDataStore("h", {64, 48}));
+    slice_.assign(D_, 0, 1, {0, 0});
+    view_ = new QHeatMapDataView;
+    view_->setData(&slice_);
+    heatMap_ = qobject_cast<QHeatMapWidget *>(view_->view());
+}
+
+void TestDataViews::cleanup()
+{
+    delete view_;
+    view_ = nullptr;
+    heatMap_ = nullptr;
+    slice_.clear();
+    D_.clear();
+}
+
+QImage TestDataViews::fullImage() const
+{
+    return QHeatMapWidget::mapImage(heatMap_->colorMap(),
+                                    slice_.data().data(),
+                                    int(slice_.dim()[0]),
+                                    int(slice_.dim()[1]));
+}
+
+void TestDataViews::setRow(size_t j, double v)
+{
+    for (size_t i = 0; i < slice_.dim()[0]; ++i)
+        synthetic(D_).setValue({i, j}, v + 1e-3 * i);
+}
+
+// rows reported changed are recolored in place, the image is the same as
+// mapping all the data
+void TestDataViews::heatMapRows()
+{
+    QVERIFY(heatMap_);
+    QCOMPARE(heatMap_->image(), fullImage());
+
+    view_->setFixedLimits(-1., 2.);
+    QCOMPARE(heatMap_->image(), fullImage());
+
+    setRow(7, 0.5);
+    slice_.update(1, 7, 8);
+    QVERIFY((slice_.changed_rows() == DataSlice::ranges_t{{7, 8}}));
+    view_->updateView();
+    QCOMPARE(heatMap_->image(), fullImage());
+    QCOMPARE(heatMap_->colorMap().lo(), -1.);
+}
+
+// only the rows that differ are reported by a ranged update
+void TestDataViews::heatMapRowsRange()
+{
+    view_->setFixedLimits(-1., 2.);
+    for (size_t j : {3, 4, 10, 47})
+        setRow(j, 1.5);
+    slice_.update(1, 0, 40);
+    QVERIFY((slice_.changed_rows() == DataSlice::ranges_t{{3, 5}, {10, 11}}));
+    view_->updateView();
+    QVERIFY(slice_(0, 47) != 1.5);
+    QCOMPARE(heatMap_->image(), fullImage());
+
+    // row 47 is read with the next full update
+    slice_.update();
+    QVERIFY((slice_.changed_rows() == DataSlice::ranges_t{{47, 48}}));
+    view_->updateView();
+    QCOMPARE(slice_(0, 47), 1.5);
+    QCOMPARE(heatMap_->image(), fullImage());
+}
+
+// a full update finds the rows that differ, only those are recolored
+void TestDataViews::heatMapRowsUpdate()
+{
+    view_->setFixedLimits(-1., 2.);
+    setRow(12, 0.25);
+    setRow(30, 0.75);
+    slice_.update();
+    QVERIFY((slice_.changed_rows() == DataSlice::ranges_t{{12, 13}, {30, 31}}));
+    view_->updateView();
+    QCOMPARE(heatMap_->image(), fullImage());
+}
+
+// with the slice limits, a changed row that extends the range recolors
+// the whole image
+void TestDataViews::heatMapRowsAutoLimits()
+{
+    view_->setLimitsMode(QHeatMapDataView::SliceLimits);
+    const double lo = heatMap_->colorMap().lo(), hi = heatMap_->colorMap().hi();
+    setRow(20, 0.5);
+    slice_.update(1, 20, 21);
+    view_->updateView();
+    QCOMPARE(heatMap_->colorMap().lo(), lo);
+    QCOMPARE(heatMap_->colorMap().hi(), hi);
+    QCOMPARE(heatMap_->image(), fullImage());
+
+    setRow(21, 10.);
+    slice_.update(1, 21, 22);
+    view_->updateView();
+    QVERIFY(heatMap_->colorMap().hi() > 10.);
+    QCOMPARE(heatMap_->image(), fullImage());
+}
+
+QTEST_MAIN(TestDataViews)
+#include "tst_dataviews.moc"
@@ -0,0 +1,146 @@
+#include "linedecimator.h"
+
+#include <QtTest>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// a noisy line with NaN gaps
+void makeLine(size_t n, std::vector<double> &x, std::vector<double> &y)
+{
+    x.resize(n);
+    y.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        x[i] = 0.5 * i;
+        y[i] = std::sin(1e-3 * i) + 0.1 * std::sin(0.7 * i * i);
+        if (i % 9973 < 3)
+            y[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+// the min & max of every bucket of w points of the full line, in x order,
+// as LineDecimator::line() draws them
+void referenceLine(const std::vector<double> &x,
+                   const std::vector<double> &y,
+                   size_t w,
+                   std::vector<double> &rx,
+                   std::vector<double> &ry)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    rx.clear();
+    ry.clear();
+    for (size_t k = 0; k < x.size(); k += w)
+    {
+        size_t lo = x.size(), hi = x.size();
+        bool hasNan = false;
+        for (size_t i = k; i < std::min(k + w, x.size()); ++i)
+        {
+            if (std::isnan(y[i]))
+            {
+                hasNan = true;
+                continue;
+            }
+            if (lo == x.size() || y[i] < y[lo])
+                lo = i;
+            if (hi == x.size() || y[i] > y[hi])
+                hi = i;
+        }
+        if (lo == x.size())
+        {
+            rx.push_back(x[k]);
+            ry.push_back(nan);
+            continue;
+        }
+        size_t a = std::min(lo, hi), b = std::max(lo, hi);
+        rx.push_back(x[a]);
+        ry.push_back(y[a]);
+        if (a != b)
+        {
+            rx.push_back(x[b]);
+            ry.push_back(y[b]);
+        }
+        if (hasNan && w > 1)
+        {
+            rx.push_back(rx.back());
+            ry.push_back(nan);
+        }
+    }
+}
+
+bool sameLine(const std::vector<double> &x1,
+              const std::vector<double> &y1,
+              const std::vector<double> &x2,
+              const std::vector<double> &y2)
+{
+    if (x1.size() != x2.size() || y1.size() != y2.size())
+        return false;
+    for (size_t i = 0; i < x1.size(); ++i)
+    {
+        if (x1[i] != x2[i] || !(y1[i] == y2[i] || (std::isnan(y1[i]) && std::isnan(y2[i]))))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+class TestLineDecimator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void envelope_data();
+    void envelope();
+};
+
+void TestLineDecimator::envelope_data()
+{
+    QTest::addColumn<int>("points");
+    QTest::addColumn<int>("chunk");
+
+    QTest::newRow("short") << 1000 << 1000;
+    QTest::newRow("full") << 4096 << 100;
+    QTest::newRow("long") << 100000 << 100000;
+    QTest::newRow("long_appended") << 100000 << 777;
+    QTest::newRow("long_appended_by_1") << 30000 << 1;
+}
+
+// the decimated line is the min/max envelope of the full line, whether
+// the points are appended at once or as the data grows
+void TestLineDecimator::envelope()
+{
+    QFETCH(int, points);
+    QFETCH(int, chunk);
+
+    std::vector<double> x, y;
+    makeLine(points, x, y);
+
+    LineDecimator dec(1024);
+    for (int i = 0; i < points; i += chunk)
+        dec.append(x.data() + i, y.data() + i, std::min(chunk, points - i));
+    QCOMPARE(dec.size(), size_t(points));
+
+    // the smallest power of 2 width that fits in the buckets
+    size_t w = 1;
+    while ((size_t(points) + w - 1) / w > dec.maxBuckets())
+        w *= 2;
+    QCOMPARE(dec.width(), w);
+
+    std::vector<double> dx, dy, rx, ry;
+    dec.line(dx, dy);
+    referenceLine(x, y, w, rx, ry);
+    QVERIFY(dx.size() <= 3 * dec.maxBuckets());
+    QVERIFY(sameLine(dx, dy, rx, ry));
+
+    dec.clear();
+    QCOMPARE(dec.size(), size_t(0));
+    dec.line(dx, dy);
+    QVERIFY(dx.empty());
+}
+
+QTEST_MAIN(TestLineDecimator)
+#include "tst_linedecimator.moc"
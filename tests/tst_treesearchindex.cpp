@@ -0,0 +1,261 @@
+#include "treesearchindex.h"
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+// the nodes of the index, searched by a scan
+class BruteForce
+{
+public:
+    typedef TreeSearchIndex::id_t id_t;
+
+    void add(id_t parent, const QString &name, const QString &desc)
+    {
+        nodes_.push_back({parent, true, lower(name), lower(desc)});
+    }
+    void describe(id_t id, const QString &desc) { nodes_[id].desc = lower(desc); }
+    void remove(id_t id) { nodes_[id].alive = false; }
+    bool alive(id_t id) const { return nodes_[id].alive; }
+    size_t size() const
+    {
+        size_t n = 0;
+        for (const node &e : nodes_)
+            n += e.alive;
+        return n;
+    }
+
+    std::vector<id_t> find(const QString &query) const
+    {
+        std::vector<id_t> ids;
+        std::string q = lower(query);
+        if (q.empty())
+            return ids;
+        for (id_t id = 0; id < nodes_.size(); ++id)
+        {
+            const node &e = nodes_[id];
+            if (e.alive
+                && (e.name.find(q) != std::string::npos || e.desc.find(q) != std::string::npos
+                    || (q.find('/') != std::string::npos && path(id).find(q) != std::string::npos)))
+                ids.push_back(id);
+        }
+        return ids;
+    }
+
+private:
+    struct node
+    {
+        id_t parent;
+        bool alive;
+        std::string name, desc;
+    };
+    std::vector<node> nodes_;
+
+    static std::string lower(const QString &s) { return s.toLower().toUtf8().toStdString(); }
+    std::string path(id_t id) const
+    {
+        const node &e = nodes_[id];
+        return (e.parent == TreeSearchIndex::npos ? std::string() : path(e.parent)) + "/" + e.name;
+    }
+};
+
+} // namespace
+
+class TestTreeSearchIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void find_data();
+    void find();
+    void describe();
+    void removeAndRebuild();
+    void removeMany();
+
+private:
+    TreeSearchIndex index_;
+    BruteForce ref_;
+    // ids of the reference, the index renumbers its ids when it is compacted
+    std::vector<TreeSearchIndex::id_t> groups_, items_;
+    std::vector<TreeSearchIndex::id_t> ids_;
+    size_t compactions_{0};
+
+    void add(TreeSearchIndex::id_t parent, const QString &name, const QString &desc);
+    // all queries, in typing order so that they narrow the previous one
+    bool compare(const QStringList &queries, QString &msg);
+    static QStringList queries();
+};
+
+void TestTreeSearchIndex::add(TreeSearchIndex::id_t parent, const QString &name, const QString &desc)
+{
+    TreeSearchIndex::id_t id = index_.add(parent == TreeSearchIndex::npos ? parent : ids_[parent], name, desc);
+    (parent == TreeSearchIndex::npos ? groups_ : items_).push_back(TreeSearchIndex::id_t(ids_.size()));
+    ids_.push_back(id);
+    ref_.add(parent, name, desc);
+}
+
+// 20 groups of 200 datasets
+void TestTreeSearchIndex::init()
+{
+    index_.clear();
+    index_.compacted = [this](const std::vector<TreeSearchIndex::id_t> &newId) {
+        for (TreeSearchIndex::id_t &id : ids_)
+            if (id != TreeSearchIndex::npos)
+                id = newId[id];
+        ++compactions_;
+    };
+    ref_ = BruteForce();
+    groups_.clear();
+    items_.clear();
+    ids_.clear();
+    compactions_ = 0;
+    for (int g = 0; g < 20; ++g)
+        add(TreeSearchIndex::npos, QString("Group") + QString::number(g), QString("run ") + QString::number(g));
+    for (int k = 0; k < 4000; ++k)
+        add(groups_[k % 20],
+            QString("D") + QString::number(k),
+            k % 3 ? QString("Temperature") : QString());
+}
+
+QStringList TestTreeSearchIndex::queries()
+{
+    QStringList l;
+    l << "d" << "d1" << "d12" << "D123" << "d1234" << "d12345" << "1" << "group1" << "roup1/"
+      << "/group1/d1" << "/GROUP1/D12" << "temp" << "tempe" << "mperature" << "run 1" << "volt"
+      << "zzz" << "";
+    return l;
+}
+
+bool TestTreeSearchIndex::compare(const QStringList &queries, QString &msg)
+{
+    for (const QString &q : queries)
+    {
+        std::vector<TreeSearchIndex::id_t> expected = ref_.find(q);
+        for (TreeSearchIndex::id_t &id : expected)
+            id = ids_[id];
+        for (size_t max : {size_t(10), size_t(100000)})
+        {
+            std::vector<TreeSearchIndex::id_t> ids;
+            bool all = index_.find(q, max, ids);
+            std::vector<TreeSearchIndex::id_t> first(expected.begin(),
+                                                     expected.begin() + std::min(max, expected.size()));
+            if (all != (expected.size() <= max) || ids != first)
+            {
+                msg = QString("query '") + q + QString("', max ") + QString::number(max);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void TestTreeSearchIndex::find_data()
+{
+    QTest::addColumn<bool>("reversed");
+
+    QTest::newRow("narrowing") << false;
+    QTest::newRow("widening") << true;
+}
+
+// the trigram index, the scans & the narrowing of the last matches
+// against a scan of all nodes
+void TestTreeSearchIndex::find()
+{
+    QFETCH(bool, reversed);
+
+    QStringList q = queries();
+    if (reversed)
+        std::reverse(q.begin(), q.end());
+    QCOMPARE(index_.size(), ref_.size());
+    QString msg;
+    QVERIFY2(compare(q, msg), qPrintable(msg));
+}
+
+// new descriptions are found, the old ones are not
+void TestTreeSearchIndex::describe()
+{
+    QString msg;
+    QVERIFY2(compare(queries(), msg), qPrintable(msg));
+    for (size_t k = 0; k < items_.size(); k += 7)
+    {
+        const QString desc = k % 2 ? QString("Voltage") : QString();
+        index_.describe(ids_[items_[k]], desc);
+        ref_.describe(items_[k], desc);
+    }
+    QVERIFY2(compare(queries(), msg), qPrintable(msg));
+}
+
+// removed nodes are not found, also after the index is compacted
+// (more than half of the nodes removed) & new nodes are added
+void TestTreeSearchIndex::removeAndRebuild()
+{
+    QString msg;
+    QVERIFY2(compare(queries(), msg), qPrintable(msg));
+    for (size_t k = 0; k < items_.size(); ++k)
+    {
+        if (k % 3 == 0)
+            continue;
+        index_.remove(ids_[items_[k]]);
+        // removing twice does nothing
+        if (k == 1)
+            index_.remove(ids_[items_[k]]);
+        ref_.remove(items_[k]);
+        ids_[items_[k]] = TreeSearchIndex::npos;
+        // before & after the compaction
+        if (k == 1000 || k == 3998)
+        {
+            QCOMPARE(index_.size(), ref_.size());
+            QVERIFY2(compare(queries(), msg), qPrintable(msg));
+        }
+    }
+    QCOMPARE(compactions_, size_t(1));
+    QCOMPARE(index_.size(), ref_.size());
+
+    for (int k = 0; k < 100; ++k)
+        add(groups_[k % 20], QString("d1") + QString::number(k), QString("Voltage"));
+    QVERIFY2(compare(queries(), msg), qPrintable(msg));
+}
+
+// removing 10k nodes one by one takes linear time & the memory of the
+// removed nodes is released
+// QTDATABROWSER_BUDGET_MS overrides the default for slow machines
+void TestTreeSearchIndex::removeMany()
+{
+    double budget_ms = 250;
+    if (!qEnvironmentVariableIsEmpty("QTDATABROWSER_BUDGET_MS"))
+        budget_ms = qEnvironmentVariable("QTDATABROWSER_BUDGET_MS").toDouble();
+
+    for (int k = 4000; k < 10000; ++k)
+        add(groups_[k % 20], QString("D") + QString::number(k), QString("Current"));
+    const size_t full = index_.memory_usage();
+
+    QElapsedTimer tmr;
+    tmr.start();
+    for (size_t k = 0; k < items_.size(); ++k)
+    {
+        if (k % 1000 == 0)
+            continue;
+        index_.remove(ids_[items_[k]]);
+        ref_.remove(items_[k]);
+        ids_[items_[k]] = TreeSearchIndex::npos;
+    }
+    const double t = tmr.nsecsElapsed() * 1e-6;
+    QVERIFY2(t < budget_ms,
+             qPrintable(QString("removing 10k nodes took %1 ms, budget %2 ms").arg(t).arg(budget_ms)));
+
+    QCOMPARE(index_.size(), ref_.size());
+    QVERIFY(compactions_ > 0);
+    QVERIFY2(index_.memory_usage() < full / 4,
+             qPrintable(QString("%1 bytes left of %2").arg(index_.memory_usage()).arg(full)));
+    QString msg;
+    QVERIFY2(compare(queries(), msg), qPrintable(msg));
+}
+
+QTEST_MAIN(TestTreeSearchIndex)
+#include "tst_treesearchindex.moc"